@@ -0,0 +1,223 @@
+#include"anneal.h"
+
+#include<stdio.h>
+
+#include<cmath>
+#include<vector>
+
+#include"assignment.h"
+#include"delta_score.h"
+#include"moves.h"
+
+namespace {
+
+// Number of trial moves used to calibrate initial temperature.
+static constexpr int kCalibrationMoves = 200;
+
+// Number of steps between clock checks.
+static constexpr int kClockCheckInterval = 64;
+
+// Fraction of steps that toggle mute instead of moving musicians, if
+// mute moves are enabled.
+static constexpr double kMuteProbability = 0.05;
+
+// Volume for unmuted musicians.  Volume only scales each musician's
+// contribution, so the best volume is always either zero or maximum.
+static constexpr double kMaxVolume = 10;
+
+// Acceptance statistics for one temperature level.
+struct LevelStats
+{
+   double temperature = 0;
+   int attempts = 0;
+   int accepted = 0;
+   int improved = 0;
+};
+
+// Make a random move through journal, and apply the same move to scorer.
+// Returns the operator used, or -1 if no move was made.
+static int ProposeMove(MoveSet *moves,
+                       std::default_random_engine &rng,
+                       MoveJournal *journal,
+                       DeltaScorer *scorer)
+{
+   const int op = moves->Propose(rng, journal);
+   if( op >= 0 )
+      scorer->Apply(journal->entries(), *journal->grid());
+   return op;
+}
+
+// Undo the pending move in both journal and scorer.
+static void RejectMove(MoveJournal *journal, DeltaScorer *scorer)
+{
+   scorer->Undo(journal->entries(), *journal->grid());
+   journal->Rollback();
+}
+
+// Select initial temperature such that the average worsening move is
+// accepted with probability 'acceptance'.
+static double InitialTemperature(double acceptance,
+                                 MoveSet *moves,
+                                 std::default_random_engine &rng,
+                                 MoveJournal *journal,
+                                 DeltaScorer *scorer)
+{
+   double worsening_sum = 0;
+   int worsening_count = 0;
+   for(int i = 0; i < kCalibrationMoves; i++)
+   {
+      const double old_score = scorer->score();
+      if( ProposeMove(moves, rng, journal, scorer) < 0 )
+         continue;
+      const double delta = scorer->score() - old_score;
+      if( delta < 0 )
+      {
+         worsening_sum -= delta;
+         worsening_count++;
+      }
+      RejectMove(journal, scorer);
+   }
+
+   if( worsening_count == 0 )
+      return 1;
+   return worsening_sum / worsening_count / -std::log(acceptance);
+}
+
+}  // namespace
+
+void Anneal(const Problem &problem,
+            const SolveOptions &options,
+            const CellValues &values,
+            int attendee_count,
+            std::chrono::steady_clock::duration duration,
+            ProposalSampler *sampler,
+            AssignmentBudget *assignment_budget,
+            MoveJournal *journal,
+            std::default_random_engine &rng,
+            Solution *solution)
+{
+   const auto start_time = std::chrono::steady_clock::now();
+   DeltaScorer scorer(problem, journal->placements(), solution->volumes,
+                      attendee_count);
+
+   MoveSet moves(problem, sampler);
+   const double initial_temperature =
+      InitialTemperature(options.anneal_acceptance, &moves, rng, journal,
+                         &scorer);
+
+   double current_score = scorer.score();
+   double best_score = current_score;
+   std::vector<Cell> best_cells = journal->cells();
+   std::vector<double> best_volumes = solution->volumes;
+   const int musician_count = static_cast<int>(best_volumes.size());
+   std::uniform_int_distribution<> select_musician(0, musician_count - 1);
+
+   const int levels = options.anneal_levels;
+   std::vector<LevelStats> stats(levels);
+   std::uniform_real_distribution<> unit(0.0, 1.0);
+   for(int level = 0; level < levels; level++)
+   {
+      LevelStats &s = stats[level];
+      s.temperature = initial_temperature *
+         (levels > 1 ? std::pow(options.anneal_final_ratio,
+                                static_cast<double>(level) / (levels - 1))
+                     : 1);
+      const auto level_end = start_time + duration * (level + 1) / levels;
+
+      if( options.assignment && assignment_budget->Available() )
+      {
+         solution->counters[Solution::kReassignments]++;
+         if( assignment_budget->Reassign(problem, values, rng, journal,
+                                         &scorer) )
+         {
+            solution->counters[Solution::kReassignmentsKept]++;
+            current_score = scorer.score();
+            if( best_score < current_score )
+            {
+               best_score = current_score;
+               best_cells = journal->cells();
+               best_volumes = solution->volumes;
+               s.improved++;
+            }
+         }
+      }
+
+      for(int step = 0;
+          step % kClockCheckInterval != 0 ||
+          std::chrono::steady_clock::now() < level_end;
+          step++)
+      {
+         if( options.mute_moves && unit(rng) < kMuteProbability )
+         {
+            // Toggle mute for one musician.  Journal is committed here,
+            // so only volumes change.
+            const int m = select_musician(rng);
+            const double old_volume = scorer.volume(m);
+            scorer.SetVolume(m, old_volume > 0 ? 0 : kMaxVolume);
+            s.attempts++;
+            solution->counters[Solution::kMuteToggles]++;
+
+            const double delta = scorer.score() - current_score;
+            if( delta < 0 && unit(rng) >= std::exp(delta / s.temperature) )
+            {
+               scorer.SetVolume(m, old_volume);
+               continue;
+            }
+
+            solution->volumes[m] = scorer.volume(m);
+            current_score = scorer.score();
+            s.accepted++;
+            solution->counters[Solution::kMuteAccepted]++;
+            if( best_score < current_score )
+            {
+               best_score = current_score;
+               best_cells = journal->cells();
+               best_volumes = solution->volumes;
+               s.improved++;
+            }
+            continue;
+         }
+
+         const int op = ProposeMove(&moves, rng, journal, &scorer);
+         if( op < 0 )
+            continue;
+         s.attempts++;
+         solution->counters[Solution::kAnnealMoves]++;
+
+         const double delta = scorer.score() - current_score;
+         const bool accept =
+            delta >= 0 || unit(rng) < std::exp(delta / s.temperature);
+         moves.Record(op, delta, accept);
+         if( !accept )
+         {
+            RejectMove(journal, &scorer);
+            continue;
+         }
+
+         journal->Commit();
+         current_score = scorer.score();
+         s.accepted++;
+         solution->counters[Solution::kAnnealAccepted]++;
+         if( best_score < current_score )
+         {
+            best_score = current_score;
+            best_cells = journal->cells();
+            best_volumes = solution->volumes;
+            s.improved++;
+         }
+      }
+   }
+   journal->Restore(best_cells);
+   solution->volumes = best_volumes;
+
+   for(int level = 0; level < levels; level++)
+   {
+      const LevelStats &s = stats[level];
+      fprintf(stderr, "Anneal level %d: T = %.1f, accepted %d of %d "
+              "(%.1f%%), %d new best\n",
+              level, s.temperature, s.accepted, s.attempts,
+              s.attempts > 0 ? 100.0 * s.accepted / s.attempts : 0.0,
+              s.improved);
+   }
+   moves.PrintStats(stderr);
+}
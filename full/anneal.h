@@ -0,0 +1,49 @@
+#ifndef ANNEAL_H_
+#define ANNEAL_H_
+
+#include<chrono>
+#include<random>
+#include"assignment.h"
+#include"cell_values.h"
+#include"move_journal.h"
+#include"problem.h"
+#include"proposal.h"
+#include"solution.h"
+
+// Improve placements with simulated annealing.
+//
+// Each step applies one operator from MoveSet, selected adaptively by
+// observed improvement per evaluation.  Steps are scored with
+// DeltaScorer over the first 'attendee_count' attendees, and accepted
+// with Metropolis criterion at the current temperature.
+//
+// Temperature starts at a value calibrated from sampled worsening moves,
+// and decreases geometrically over options.anneal_levels levels, each
+// level getting an equal share of 'duration'.  Acceptance statistics for
+// each level are written to stderr at the end.
+//
+// If options.assignment is set, instruments are reassigned to occupied
+// cells with ReassignInstruments at the start of each level, as long as
+// 'assignment_budget' allows.
+//
+// If options.mute_moves is set, some steps toggle a single musician
+// between zero and full volume instead of moving musicians, so that
+// net-negative musicians are muted during search and then become free to
+// act as blockers.  Solution volumes are updated to match the best
+// placements.
+//
+// 'journal' must be in committed state on entry.  On return, it holds the
+// best placements seen.  Destination cells are drawn from 'sampler' if
+// available, otherwise they are uniformly random.
+void Anneal(const Problem &problem,
+            const SolveOptions &options,
+            const CellValues &values,
+            int attendee_count,
+            std::chrono::steady_clock::duration duration,
+            ProposalSampler *sampler,
+            AssignmentBudget *assignment_budget,
+            MoveJournal *journal,
+            std::default_random_engine &rng,
+            Solution *solution);
+
+#endif  // ANNEAL_H_
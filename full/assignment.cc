@@ -0,0 +1,219 @@
+#include"assignment.h"
+
+#include<algorithm>
+#include<limits>
+
+namespace {
+
+// Number of swaps to try during repair.  Each swap costs two delta
+// updates, so this is kept small relative to the cost of assignment.
+static constexpr int kRepairSwaps = 64;
+
+// Approximate time per step of matching and scorer construction, used to
+// estimate the cost of the first reassignment.  Measured at about 2-7ns
+// with -O3, rounded up.
+static constexpr double kSecondsPerStep = 5e-9;
+
+}  // namespace
+
+std::vector<Cell> OptimalAssignment(const Problem &problem,
+                                    const CellValues &values,
+                                    const std::vector<Cell> &cells)
+{
+   // Hungarian algorithm with potentials, minimizing negated values.
+   // Rows are musicians and columns are cells, both 1-based, with column
+   // 0 used as a virtual starting point for each augmenting path.
+   const int n = static_cast<int>(cells.size());
+   const double kInfinity = std::numeric_limits<double>::infinity();
+   std::vector<double> u(n + 1, 0), v(n + 1, 0), min_slack(n + 1);
+   std::vector<int> owner(n + 1, 0), way(n + 1, 0);
+   std::vector<char> used(n + 1);
+
+   for(int row = 1; row <= n; row++)
+   {
+      owner[0] = row;
+      int j0 = 0;
+      std::fill(min_slack.begin(), min_slack.end(), kInfinity);
+      std::fill(used.begin(), used.end(), 0);
+      do
+      {
+         used[j0] = 1;
+         const int i0 = owner[j0];
+         const int instrument = problem.musicians()[i0 - 1];
+         double delta = kInfinity;
+         int j1 = 0;
+         for(int j = 1; j <= n; j++)
+         {
+            if( used[j] )
+               continue;
+            const double cost =
+               -values.PillarAwareValue(cells[j - 1], instrument) -
+               u[i0] - v[j];
+            if( cost < min_slack[j] )
+            {
+               min_slack[j] = cost;
+               way[j] = j0;
+            }
+            if( min_slack[j] < delta )
+            {
+               delta = min_slack[j];
+               j1 = j;
+            }
+         }
+         for(int j = 0; j <= n; j++)
+         {
+            if( used[j] )
+            {
+               u[owner[j]] += delta;
+               v[j] -= delta;
+            }
+            else
+            {
+               min_slack[j] -= delta;
+            }
+         }
+         j0 = j1;
+      } while( owner[j0] != 0 );
+
+      // Flip assignments along augmenting path.
+      do
+      {
+         const int j1 = way[j0];
+         owner[j0] = owner[j1];
+         j0 = j1;
+      } while( j0 != 0 );
+   }
+
+   // Musicians of the same instrument are interchangeable, so the
+   // assignment may shuffle them among cells for no gain.  Collect the
+   // assigned cells per instrument, and let musicians keep their current
+   // cell if it's among the ones assigned to their instrument.
+   std::vector<std::vector<int>> instrument_cells(
+      problem.instruments().size());
+   for(int j = 1; j <= n; j++)
+      instrument_cells[problem.musicians()[owner[j] - 1]].push_back(j - 1);
+
+   std::vector<int> cell_instrument(n);
+   for(int j = 1; j <= n; j++)
+      cell_instrument[j - 1] = problem.musicians()[owner[j] - 1];
+
+   std::vector<Cell> targets(n);
+   std::vector<char> kept(n, 0);
+   for(int m = 0; m < n; m++)
+   {
+      if( cell_instrument[m] == problem.musicians()[m] )
+      {
+         targets[m] = cells[m];
+         kept[m] = 1;
+      }
+   }
+   for(int m = 0; m < n; m++)
+   {
+      if( kept[m] )
+         continue;
+      std::vector<int> &candidates = instrument_cells[problem.musicians()[m]];
+      while( kept[candidates.back()] )
+         candidates.pop_back();
+      targets[m] = cells[candidates.back()];
+      candidates.pop_back();
+   }
+   return targets;
+}
+
+bool ReassignInstruments(const Problem &problem,
+                         const CellValues &values,
+                         std::default_random_engine &rng,
+                         MoveJournal *journal,
+                         DeltaScorer *scorer)
+{
+   const double old_score = scorer->score();
+   const std::vector<Cell> targets =
+      OptimalAssignment(problem, values, journal->cells());
+
+   std::vector<int> group;
+   for(int m = 0; m < static_cast<int>(targets.size()); m++)
+      group.push_back(m);
+   if( journal->MoveGroup(group, targets) == 0 )
+      return false;
+   scorer->Apply(journal->entries(), *journal->grid());
+
+   // Repair: try swapping random pairs of reassigned musicians, keeping
+   // swaps that improve the blocking-aware score.
+   std::vector<int> changed;
+   for(const MoveJournal::Entry &e : journal->entries())
+      changed.push_back(e.musician);
+   std::sort(changed.begin(), changed.end());
+   changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+   std::uniform_int_distribution<> select(
+      0, static_cast<int>(changed.size()) - 1);
+   for(int i = 0; i < kRepairSwaps; i++)
+   {
+      const int a = changed[select(rng)];
+      const int b = changed[select(rng)];
+      if( problem.musicians()[a] == problem.musicians()[b] )
+         continue;
+      const double before = scorer->score();
+      journal->Swap(a, b);
+      scorer->Swap(a, b);
+      if( scorer->score() <= before )
+      {
+         journal->Swap(a, b);
+         scorer->Swap(a, b);
+      }
+   }
+
+   if( scorer->score() <= old_score )
+   {
+      scorer->Undo(journal->entries(), *journal->grid());
+      journal->Rollback();
+      return false;
+   }
+   journal->Commit();
+   return true;
+}
+
+AssignmentBudget::AssignmentBudget(double share,
+                                   const Problem &problem,
+                                   int attendee_count)
+   : share_(share),
+     attendee_count_(attendee_count),
+     start_(std::chrono::steady_clock::now())
+{
+   // Matching takes O(M^3) steps, and building a scorer O(M^2 * A).
+   const double m = static_cast<double>(problem.musicians().size());
+   const double a = static_cast<double>(
+      std::min<size_t>(attendee_count, problem.attendees().size()));
+   last_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(kSecondsPerStep * (m * m * m + m * m * a)));
+}
+
+bool AssignmentBudget::Reassign(const Problem &problem,
+                                const CellValues &values,
+                                std::default_random_engine &rng,
+                                MoveJournal *journal,
+                                DeltaScorer *scorer)
+{
+   const auto start_time = std::chrono::steady_clock::now();
+   const bool changed =
+      ReassignInstruments(problem, values, rng, journal, scorer);
+   last_ = std::chrono::steady_clock::now() - start_time;
+   spent_ += last_;
+   return changed;
+}
+
+bool AssignmentBudget::Reassign(const Problem &problem,
+                                const CellValues &values,
+                                const std::vector<double> &volumes,
+                                std::default_random_engine &rng,
+                                MoveJournal *journal)
+{
+   const auto start_time = std::chrono::steady_clock::now();
+   DeltaScorer scorer(problem, journal->placements(), volumes,
+                      attendee_count_);
+   const bool changed =
+      ReassignInstruments(problem, values, rng, journal, &scorer);
+   last_ = std::chrono::steady_clock::now() - start_time;
+   spent_ += last_;
+   return changed;
+}
@@ -0,0 +1,83 @@
+#ifndef ASSIGNMENT_H_
+#define ASSIGNMENT_H_
+
+#include<chrono>
+#include<random>
+#include<vector>
+#include"cell_values.h"
+#include"delta_score.h"
+#include"grid.h"
+#include"move_journal.h"
+#include"problem.h"
+
+// Find the assignment of musicians to the given set of cells that
+// maximizes the sum of pillar-aware cell values, ignoring blocking by
+// other musicians and closeness.  Returns the target cell for each
+// musician, which is a permutation of 'cells'.
+//
+// This is solved with the Hungarian algorithm in O(M^3) time.
+std::vector<Cell> OptimalAssignment(const Problem &problem,
+                                    const CellValues &values,
+                                    const std::vector<Cell> &cells);
+
+// Move musicians to their optimal assignment within the currently
+// occupied cells, then repair the assignment by trying a few swaps
+// between reassigned musicians, scored with blocking.  The result is kept
+// only if it improves the score, otherwise all changes are undone.
+//
+// 'journal' must be committed on entry, and is committed on return.
+// 'scorer' must match journal placements.  Returns true if placements
+// changed.
+bool ReassignInstruments(const Problem &problem,
+                         const CellValues &values,
+                         std::default_random_engine &rng,
+                         MoveJournal *journal,
+                         DeltaScorer *scorer);
+
+// Limit time spent in ReassignInstruments to a fraction of search time.
+// Matching costs O(M^3), which is seconds on the largest problems, so
+// calling it at every annealing level or dance restart would leave little
+// time for search.  One budget is shared by all search epochs of a
+// thread, so that epochs under --islands do not each pay for a matching.
+class AssignmentBudget
+{
+public:
+   // Reassignments may use 'share' of the time since construction.
+   // Repair is scored over the first 'attendee_count' attendees.
+   AssignmentBudget(double share, const Problem &problem, int attendee_count);
+
+   // Check if another reassignment fits in the budget, assuming it costs
+   // as much as the previous one.  Before the first reassignment, cost is
+   // estimated from problem size, so that a matching too expensive for
+   // the share is never started.
+   bool Available() const
+   {
+      const auto elapsed = std::chrono::steady_clock::now() - start_;
+      return std::chrono::duration<double>(spent_ + last_).count() <=
+             share_ * std::chrono::duration<double>(elapsed).count();
+   }
+
+   // Run ReassignInstruments and charge its time to the budget.
+   bool Reassign(const Problem &problem,
+                 const CellValues &values,
+                 std::default_random_engine &rng,
+                 MoveJournal *journal,
+                 DeltaScorer *scorer);
+
+   // Same as above, for callers without a scorer.  A scorer for journal
+   // placements is built first, and its O(M^2 * A) construction is
+   // charged to the budget as well.
+   bool Reassign(const Problem &problem,
+                 const CellValues &values,
+                 const std::vector<double> &volumes,
+                 std::default_random_engine &rng,
+                 MoveJournal *journal);
+
+private:
+   double share_;
+   int attendee_count_;
+   std::chrono::steady_clock::time_point start_;
+   std::chrono::steady_clock::duration spent_{0}, last_{0};
+};
+
+#endif  // ASSIGNMENT_H_
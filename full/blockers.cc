@@ -0,0 +1,252 @@
+#include"blockers.h"
+
+#include<algorithm>
+#include<cmath>
+#include<functional>
+
+namespace {
+
+// Step size when walking along sightlines to find covering cells.  Any
+// cell within blocking radius of the sightline is within 7.5 of some
+// sample point, and thus within the 2x2 block of cells around it.
+static constexpr double kWalkStep = Grid::kCellSize / 2;
+
+// Collect indices of cells within blocking radius of the sightline from
+// performer to attendee, excluding the performer's own cell.
+static void CoveringCells(const Grid &grid,
+                          const XY &performer,
+                          const XY &attendee,
+                          std::vector<int> *cells)
+{
+   cells->clear();
+   const double dx = attendee.x - performer.x;
+   const double dy = attendee.y - performer.y;
+   const double length = std::hypot(dx, dy);
+   const XY lo = grid.ToXY(0, 0);
+   const XY hi = grid.ToXY(grid.columns() - 1, grid.rows() - 1);
+
+   // Performer is inside the grid, so the sightline leaves the grid at
+   // most once.
+   for(double t = 0; t < length; t += kWalkStep)
+   {
+      const XY p{performer.x + dx * t / length, performer.y + dy * t / length};
+      if( p.x < lo.x - kScoreBlockingRadius ||
+          p.x > hi.x + kScoreBlockingRadius ||
+          p.y < lo.y - kScoreBlockingRadius ||
+          p.y > hi.y + kScoreBlockingRadius )
+      {
+         break;
+      }
+
+      const int column = static_cast<int>(
+         std::floor((p.x - lo.x) / Grid::kCellSize));
+      const int row = static_cast<int>(
+         std::floor((p.y - lo.y) / Grid::kCellSize));
+      for(int r = row; r <= row + 1; r++)
+      {
+         for(int c = column; c <= column + 1; c++)
+         {
+            const Cell cell = Grid::MakeCell(c, r);
+            if( !grid.Contains(cell) )
+               continue;
+            const XY q = grid.ToXY(cell);
+            if( q.x == performer.x && q.y == performer.y )
+               continue;
+            if( SegmentBlocked(attendee, performer, q, kScoreBlockingRadius) )
+               cells->push_back(grid.ToIndex(cell));
+         }
+      }
+   }
+   std::sort(cells->begin(), cells->end());
+   cells->erase(std::unique(cells->begin(), cells->end()), cells->end());
+}
+
+}  // namespace
+
+int SelectBlockers(const Problem &problem,
+                   const CellValues &values,
+                   const Grid &grid,
+                   std::vector<double> *volumes)
+{
+   const int instrument_count = values.instrument_count();
+   const int musician_count = static_cast<int>(problem.musicians().size());
+   const int cell_count = grid.rows() * grid.columns();
+   std::vector<int> seen(instrument_count, 0);
+   std::vector<double> cell_values(cell_count);
+   std::vector<std::vector<double>> reachable(instrument_count);
+   for(int i = 0; i < instrument_count; i++)
+   {
+      const int players = std::min(cell_count, problem.instruments()[i]);
+      if( players == 0 )
+         continue;
+      for(int c = 0; c < cell_count; c++)
+         cell_values[c] = values.PillarAwareValue(grid.FromIndex(c), i);
+      std::partial_sort(cell_values.begin(), cell_values.begin() + players,
+                        cell_values.end(), std::greater<double>());
+      reachable[i].assign(cell_values.begin(),
+                          cell_values.begin() + players);
+   }
+
+   int count = 0;
+   for(int m = 0; m < musician_count; m++)
+   {
+      const int i = problem.musicians()[m];
+      const int rank = seen[i]++;
+      const double value =
+         rank < static_cast<int>(reachable[i].size()) ? reachable[i][rank] : 0;
+      if( value <= 0 )
+      {
+         (*volumes)[m] = 0;
+         count++;
+      }
+   }
+   return count;
+}
+
+int PlaceBlockers(const Problem &problem,
+                  const std::vector<double> &volumes,
+                  int attendee_count,
+                  MoveJournal *journal)
+{
+   const Grid &grid = *journal->grid();
+   const int musician_count = static_cast<int>(problem.musicians().size());
+   std::vector<int> performers, blockers;
+   std::vector<XY> performer_positions;
+   for(int m = 0; m < musician_count; m++)
+   {
+      if( volumes[m] == 0 )
+      {
+         blockers.push_back(m);
+      }
+      else
+      {
+         performers.push_back(m);
+         performer_positions.push_back(journal->placements()[m]);
+      }
+   }
+   if( blockers.empty() || performers.empty() )
+      return 0;
+
+   // Collect sightlines that are not already blocked, along with the
+   // cells that would block them.  Cell lists are stored contiguously,
+   // with line_start[i] marking the start of line i.
+   const int cell_count = grid.rows() * grid.columns();
+   const int performer_count = static_cast<int>(performers.size());
+   std::vector<double> line_weight;
+   std::vector<int> line_start(1, 0);
+   std::vector<int> line_cells;
+   std::vector<double> gain(cell_count, 0);
+   std::vector<int> cells;
+   for(int k = 0; k < performer_count; k++)
+   {
+      const int m = performers[k];
+      const XY &p = performer_positions[k];
+      const int instrument = problem.musicians()[m];
+      for(int j = 0; j < attendee_count; j++)
+      {
+         const Problem::Attendee &a = problem.attendees()[j];
+         const double taste = a.tastes[instrument];
+         if( taste == 0 ||
+             problem.BlockedByPillar(a.position, p) ||
+             ScoreCore<double, false, false, false>::BlockedByMusician(
+                performer_positions.data(), performer_count, k, a.position) )
+         {
+            continue;
+         }
+
+         CoveringCells(grid, p, a.position, &cells);
+         if( cells.empty() )
+            continue;
+
+         const double dx = a.position.x - p.x;
+         const double dy = a.position.y - p.y;
+         const double weight =
+            volumes[m] * std::ceil(1e6 * taste / (dx * dx + dy * dy));
+         line_weight.push_back(weight);
+         line_cells.insert(line_cells.end(), cells.begin(), cells.end());
+         line_start.push_back(static_cast<int>(line_cells.size()));
+         for(int c : cells)
+            gain[c] -= weight;
+      }
+   }
+
+   // Build inverse index from cells to lines.
+   const int line_count = static_cast<int>(line_weight.size());
+   std::vector<int> cell_start(cell_count + 1, 0);
+   for(int c : line_cells)
+      cell_start[c + 1]++;
+   for(int c = 0; c < cell_count; c++)
+      cell_start[c + 1] += cell_start[c];
+   std::vector<int> cell_lines(line_cells.size());
+   std::vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+   for(int i = 0; i < line_count; i++)
+   {
+      for(int j = line_start[i]; j < line_start[i + 1]; j++)
+         cell_lines[fill[line_cells[j]]++] = i;
+   }
+
+   // Cells occupied by performers are not available.  Cells occupied by
+   // blockers are available, since blockers are being placed.
+   std::vector<char> available(cell_count, 0);
+   for(int c = 0; c < cell_count; c++)
+      available[c] = grid.Get(grid.FromIndex(c)) == 0;
+   for(int m : blockers)
+      available[grid.ToIndex(journal->cells()[m])] = 1;
+
+   // Greedily select cells with the most gain.  Once a line is covered,
+   // it no longer contributes to gain of other cells, whether it was a
+   // line we wanted to block or not.
+   std::vector<char> covered(line_count, 0);
+   std::vector<char> selected(cell_count, 0);
+   std::vector<int> targets;
+   while( targets.size() < blockers.size() )
+   {
+      int best = -1;
+      for(int c = 0; c < cell_count; c++)
+      {
+         if( available[c] && !selected[c] &&
+             (best < 0 || gain[best] < gain[c]) )
+         {
+            best = c;
+         }
+      }
+      if( best < 0 || gain[best] <= 0 )
+         break;
+
+      selected[best] = 1;
+      targets.push_back(best);
+      for(int j = cell_start[best]; j < cell_start[best + 1]; j++)
+      {
+         const int line = cell_lines[j];
+         if( covered[line] )
+            continue;
+         covered[line] = 1;
+         for(int k = line_start[line]; k < line_start[line + 1]; k++)
+            gain[line_cells[k]] += line_weight[line];
+      }
+   }
+
+   // Blockers already on a selected cell stay there, and the remaining
+   // selected cells are handed out to other blockers.
+   std::vector<int> moving;
+   for(int m : blockers)
+   {
+      const int c = grid.ToIndex(journal->cells()[m]);
+      if( selected[c] )
+         selected[c] = 0;
+      else
+         moving.push_back(m);
+   }
+   std::vector<int> group;
+   std::vector<Cell> group_targets;
+   for(int c : targets)
+   {
+      if( !selected[c] )
+         continue;
+      group.push_back(moving[group.size()]);
+      group_targets.push_back(grid.FromIndex(c));
+   }
+   const int moved = journal->MoveGroup(group, group_targets);
+   journal->Commit();
+   return moved;
+}
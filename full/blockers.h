@@ -0,0 +1,43 @@
+#ifndef BLOCKERS_H_
+#define BLOCKERS_H_
+
+#include<vector>
+#include"cell_values.h"
+#include"move_journal.h"
+#include"problem.h"
+
+// Construction stage for problems where most of the audience hates most
+// of the instruments.
+//
+// Musicians that can not contribute positive score are muted and used as
+// blockers instead.  Blockers are then placed to cover sightlines
+// between performers and attendees who dislike them.
+
+// Set volume to zero for musicians that can not contribute positive
+// score.  Musicians of the same instrument compete for the same cells, so
+// the k-th musician of an instrument can at best reach its k-th most
+// valuable cell, and is muted if that cell is not positive.  Returns
+// number of muted musicians.
+int SelectBlockers(const Problem &problem,
+                   const CellValues &values,
+                   const Grid &grid,
+                   std::vector<double> *volumes);
+
+// Move muted musicians to cells that block the most hate, given current
+// performer positions.
+//
+// Each unblocked sightline from a performer to one of the first
+// 'attendee_count' attendees with nonzero taste is weighted by its score.
+// Cells within blocking radius of a sightline cover it, and blockers are
+// placed greedily on the free cell with the largest total weight of hated
+// sightlines covered, net of loved sightlines covered.  Blockers that
+// don't have a cell with positive gain are left where they are.
+//
+// Placement is recorded in journal and committed.  Returns number of
+// blockers moved.
+int PlaceBlockers(const Problem &problem,
+                  const std::vector<double> &volumes,
+                  int attendee_count,
+                  MoveJournal *journal);
+
+#endif  // BLOCKERS_H_
@@ -0,0 +1,69 @@
+#include"cell_values.h"
+
+#include"parallel.h"
+
+#ifdef BENCHMARK
+   #include<chrono>
+   #include<iostream>
+#endif
+
+CellValues::CellValues(const Problem &problem, const Grid &grid)
+   : columns_(grid.columns()),
+     instrument_count_(static_cast<int>(problem.instruments().size()))
+{
+   #ifdef BENCHMARK
+      const auto start_time = std::chrono::steady_clock::now();
+   #endif
+
+   const int cell_count = grid.rows() * grid.columns();
+   const bool has_pillars = !problem.pillars().empty();
+   values_.resize(cell_count * instrument_count_);
+   force_x_.resize(cell_count * instrument_count_);
+   force_y_.resize(cell_count * instrument_count_);
+   if( has_pillars )
+      pillar_values_.resize(cell_count * instrument_count_);
+
+   const ScoreTables<double> &tables = problem.score_tables();
+   const int attendee_count = static_cast<int>(tables.attendees.size());
+   ParallelFor(cell_count, [&](int index)
+   {
+      const Cell cell = grid.FromIndex(index);
+      const XY p = grid.ToXY(cell);
+      double *value = values_.data() + index * instrument_count_;
+      double *pillar_value = has_pillars
+         ? pillar_values_.data() + index * instrument_count_
+         : nullptr;
+      double *force_x = force_x_.data() + index * instrument_count_;
+      double *force_y = force_y_.data() + index * instrument_count_;
+
+      const double *taste = tables.tastes.data();
+      for(int j = 0; j < attendee_count; j++, taste += instrument_count_)
+      {
+         const XY &a = tables.attendees[j];
+         const double dx = a.x - p.x;
+         const double dy = a.y - p.y;
+         const double inverse_d2 = 1 / (dx * dx + dy * dy);
+         const double scale = 1e6 * inverse_d2;
+         for(int i = 0; i < instrument_count_; i++)
+         {
+            value[i] += scale * taste[i];
+            force_x[i] += taste[i] * inverse_d2 * dx;
+            force_y[i] += taste[i] * inverse_d2 * dy;
+         }
+
+         if( has_pillars &&
+             !ScoreCore<double, true, false, false>::BlockedByPillar(
+                tables, a, p) )
+         {
+            for(int i = 0; i < instrument_count_; i++)
+               pillar_value[i] += scale * taste[i];
+         }
+      }
+   });
+
+   #ifdef BENCHMARK
+      const std::chrono::duration<double> elapsed =
+         std::chrono::steady_clock::now() - start_time;
+      std::cerr << "CellValues build time: " << elapsed.count() << "\n";
+   #endif
+}
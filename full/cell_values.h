@@ -0,0 +1,64 @@
+#ifndef CELL_VALUES_H_
+#define CELL_VALUES_H_
+
+#include<vector>
+#include"grid.h"
+#include"problem.h"
+
+// Precomputed value of placing a single musician at each grid cell,
+// for each instrument.
+//
+// Value is the sum of 1e6*taste/d^2 over all attendees, ignoring
+// blocking by other musicians, closeness and volume.  This depends only
+// on the problem, so it's computed once per grid.
+//
+// Also includes the taste force field, which is the sum of taste/d^2
+// times the unit vector toward each attendee.  Musicians are nudged
+// along these forces during initial placement.
+class CellValues
+{
+public:
+   CellValues(const Problem &problem, const Grid &grid);
+
+   // Value ignoring all blockers.
+   double Value(const Cell &cell, int instrument) const
+   {
+      return values_[Offset(cell, instrument)];
+   }
+
+   // Value ignoring musicians, but excluding attendees that are blocked
+   // by pillars.  Same as Value() for problems without pillars.
+   double PillarAwareValue(const Cell &cell, int instrument) const
+   {
+      return pillar_values_.empty()
+         ? values_[Offset(cell, instrument)]
+         : pillar_values_[Offset(cell, instrument)];
+   }
+
+   // Sum of taste forces from all attendees.
+   XY Force(const Cell &cell, int instrument) const
+   {
+      const int offset = Offset(cell, instrument);
+      return XY{force_x_[offset], force_y_[offset]};
+   }
+
+   int instrument_count() const { return instrument_count_; }
+
+private:
+   int Offset(const Cell &cell, int instrument) const
+   {
+      return (cell.row * columns_ + cell.column) * instrument_count_ +
+             instrument;
+   }
+
+   int columns_;
+   int instrument_count_;
+
+   // Tables of (row * columns + column) * instrument_count + instrument.
+   std::vector<double> values_;
+   std::vector<double> pillar_values_;
+   std::vector<double> force_x_;
+   std::vector<double> force_y_;
+};
+
+#endif  // CELL_VALUES_H_
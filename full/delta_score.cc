@@ -0,0 +1,542 @@
+#include"delta_score.h"
+
+#include<algorithm>
+#include<cmath>
+#include<limits>
+
+namespace {
+
+// Number of angular bins per attendee in MoveValues.
+static constexpr int kAngleBins = 512;
+
+// Minimum distance between musicians.
+static constexpr double kSpacing = 10;
+
+// Items sorted into bins by direction as seen from one attendee.
+//
+// Directions are measured relative to the direction toward the center of
+// the grid, so that the range spanned by grid cells doesn't wrap around.
+// Items outside of that range are clamped to the first or last bin.  If
+// the viewpoint is inside the grid, all items go to a single bin.
+class AngularBins
+{
+public:
+   AngularBins() : bins_(kAngleBins) {}
+
+   // Clear all bins and set viewpoint.  Grid cells are within the box
+   // between 'grid_min' and 'grid_max'.
+   void Reset(const XY &origin, const XY &grid_min, const XY &grid_max)
+   {
+      for(std::vector<int> &bin : bins_)
+         bin.clear();
+      origin_ = origin;
+      reference_ = XY{(grid_min.x + grid_max.x) / 2 - origin.x,
+                      (grid_min.y + grid_max.y) / 2 - origin.y};
+      const double r = kScoreBlockingRadius;
+      if( origin.x > grid_min.x - r && origin.x < grid_max.x + r &&
+          origin.y > grid_min.y - r && origin.y < grid_max.y + r )
+      {
+         bin_count_ = 1;
+         min_angle_ = -M_PI;
+         scale_ = 0;
+         return;
+      }
+
+      const XY corners[4] =
+      {
+         grid_min, XY{grid_max.x, grid_min.y},
+         XY{grid_min.x, grid_max.y}, grid_max
+      };
+      double lo = M_PI, hi = -M_PI;
+      for(const XY &c : corners)
+      {
+         const double angle = Angle(c);
+         lo = std::min(lo, angle);
+         hi = std::max(hi, angle);
+      }
+      bin_count_ = kAngleBins;
+      min_angle_ = lo;
+      scale_ = hi > lo ? bin_count_ / (hi - lo) : 0;
+   }
+
+   // Direction of 'p' relative to the reference direction.
+   double Angle(const XY &p) const
+   {
+      const double dx = p.x - origin_.x;
+      const double dy = p.y - origin_.y;
+      return std::atan2(reference_.x * dy - reference_.y * dx,
+                        reference_.x * dx + reference_.y * dy);
+   }
+
+   // Bin containing 'angle', clamped to range.
+   int Bin(double angle) const
+   {
+      const double bin = (angle - min_angle_) * scale_;
+      if( !(bin > 0) )
+         return 0;
+      return std::min(bin_count_ - 1, static_cast<int>(bin));
+   }
+
+   // Add item to all bins within 'half_width' of 'angle'.
+   void Add(int item, double angle, double half_width)
+   {
+      const int end = Bin(angle + half_width);
+      for(int b = Bin(angle - half_width); b <= end; b++)
+         bins_[b].push_back(item);
+   }
+
+   const std::vector<int> &bin(int b) const { return bins_[b]; }
+
+private:
+   XY origin_;
+   XY reference_;
+   double min_angle_;
+   double scale_;
+   int bin_count_;
+   std::vector<std::vector<int>> bins_;
+};
+
+// Upper bound on half width of the range of directions from a viewpoint
+// at distance 'd' where a disc of radius 'r' blocks lines of sight.  For
+// x <= 1/3, asin(x) < 1.02x, so the bound avoids calling asin while
+// still never excluding a blocker, since exact checks follow.
+//
+// SegmentBlocked also reports discs slightly behind the viewpoint as
+// blocking, if they are within the segment's bounding box expanded by
+// 'r'.  This is only possible when the disc is within 3r of the
+// viewpoint, in which case the disc is checked for all directions.
+static double HalfWidth(double r, double d)
+{
+   return 3 * r < d ? r / d * 1.03 : M_PI;
+}
+
+}  // namespace
+
+DeltaScorer::DeltaScorer(const Problem &problem,
+                         const std::vector<XY> &placements,
+                         const std::vector<double> &volumes,
+                         int attendee_count)
+   : problem_(problem),
+     tables_(problem.score_tables()),
+     attendee_count_(std::min(attendee_count,
+                              static_cast<int>(problem.attendees().size()))),
+     use_closeness_(problem.UseClosenessExtension()),
+     positions_(placements),
+     volumes_(volumes)
+{
+   const int musician_count = static_cast<int>(positions_.size());
+   blocker_count_.resize(musician_count * attendee_count_);
+   pillar_blocked_.resize(musician_count * attendee_count_);
+   base_.resize(musician_count * attendee_count_);
+   closeness_.assign(musician_count, 1);
+   contribution_.resize(musician_count);
+
+   for(int m = 0; m < musician_count; m++)
+      UpdateSightLines(m);
+
+   if( use_closeness_ )
+   {
+      for(int m = 0; m < musician_count; m++)
+         closeness_[m] = ClosenessFactor(m);
+   }
+
+   score_ = 0;
+   for(int m = 0; m < musician_count; m++)
+   {
+      UpdateContribution(m);
+      score_ += contribution_[m];
+   }
+}
+
+void DeltaScorer::Move(int m, const XY &position)
+{
+   const XY old_position = positions_[m];
+   if( old_position.x == position.x && old_position.y == position.y )
+      return;
+   positions_[m] = position;
+
+   UpdateBlockedMusicians(m, old_position);
+   UpdateSightLines(m);
+   if( use_closeness_ )
+      UpdateCloseness(m);
+
+   score_ -= contribution_[m];
+   UpdateContribution(m);
+   score_ += contribution_[m];
+}
+
+void DeltaScorer::Swap(int a, int b)
+{
+   const XY position_a = positions_[a];
+   Move(a, positions_[b]);
+   Move(b, position_a);
+}
+
+void DeltaScorer::SetVolume(int m, double volume)
+{
+   volumes_[m] = volume;
+   score_ -= contribution_[m];
+   UpdateContribution(m);
+   score_ += contribution_[m];
+}
+
+void DeltaScorer::Apply(const std::vector<MoveJournal::Entry> &entries,
+                        const Grid &grid)
+{
+   for(const MoveJournal::Entry &e : entries)
+   {
+      if( e.other >= 0 )
+      {
+         Swap(e.musician, e.other);
+      }
+      else
+      {
+         Move(e.musician, grid.ToXY(e.to));
+      }
+   }
+}
+
+void DeltaScorer::Undo(const std::vector<MoveJournal::Entry> &entries,
+                       const Grid &grid)
+{
+   for(int i = static_cast<int>(entries.size()); i-- > 0;)
+   {
+      const MoveJournal::Entry &e = entries[i];
+      if( e.other >= 0 )
+      {
+         Swap(e.musician, e.other);
+      }
+      else
+      {
+         Move(e.musician, grid.ToXY(e.from));
+      }
+   }
+}
+
+void DeltaScorer::MoveValues(int m,
+                             const Grid &grid,
+                             std::vector<double> *deltas) const
+{
+   const int musician_count = static_cast<int>(positions_.size());
+   const int cell_count = grid.rows() * grid.columns();
+   const int instrument = problem_.musicians()[m];
+   const XY &p = positions_[m];
+   const double volume = volumes_[m];
+   const int pillar_count = static_cast<int>(tables_.pillars.size());
+
+   std::vector<XY> cell_xy(cell_count);
+   for(int c = 0; c < cell_count; c++)
+      cell_xy[c] = grid.ToXY(grid.FromIndex(c));
+   const XY grid_min = cell_xy.front();
+   const XY grid_max = cell_xy.back();
+
+   // Cells too close to other musicians are unavailable.
+   std::vector<char> available(cell_count, 1);
+   for(int k = 0; k < musician_count; k++)
+   {
+      if( k == m )
+         continue;
+      for(int c = 0; c < cell_count; c++)
+      {
+         const double dx = cell_xy[c].x - positions_[k].x;
+         const double dy = cell_xy[c].y - positions_[k].y;
+         if( dx * dx + dy * dy < kSpacing * kSpacing )
+            available[c] = 0;
+      }
+   }
+
+   // Closeness factor of musician 'm' at each cell.
+   std::vector<double> closeness(cell_count, 1);
+   if( use_closeness_ )
+   {
+      for(int k = 0; k < musician_count; k++)
+      {
+         if( k == m || problem_.musicians()[k] != instrument )
+            continue;
+         for(int c = 0; c < cell_count; c++)
+         {
+            if( available[c] )
+            {
+               closeness[c] += 1 / std::hypot(cell_xy[c].x - positions_[k].x,
+                                              cell_xy[c].y - positions_[k].y);
+            }
+         }
+      }
+   }
+
+   // Musicians of the same instrument have their closeness factor changed
+   // by the move.  For these, sum unscaled score of sightlines visible
+   // without 'm', and unscaled score of those blocked at each cell, and
+   // apply the new closeness factor at the end.
+   std::vector<int> neighbor_index(musician_count, -1);
+   std::vector<int> neighbors;
+   if( use_closeness_ )
+   {
+      for(int k = 0; k < musician_count; k++)
+      {
+         if( k != m && problem_.musicians()[k] == instrument &&
+             volumes_[k] != 0 )
+         {
+            neighbor_index[k] = static_cast<int>(neighbors.size());
+            neighbors.push_back(k);
+         }
+      }
+   }
+   std::vector<double> neighbor_visible(neighbors.size(), 0);
+   std::vector<double> neighbor_blocked(neighbors.size() * cell_count, 0);
+
+   // Sum score over all attendees of musician 'm' at each cell, and
+   // subtract score of other musicians' sightlines blocked at each cell.
+   // Sightlines blocked only by 'm' at its current position are gained
+   // regardless of destination.
+   deltas->assign(cell_count, 0);
+   double unblocked = 0;
+   AngularBins blockers, sightlines;
+   std::vector<double> sightline_score(musician_count);
+   for(int j = 0; j < attendee_count_; j++)
+   {
+      const XY &a = tables_.attendees[j];
+      const double taste =
+         tables_.tastes[j * tables_.instrument_count + instrument];
+
+      // Blockers are other musicians, numbered from 0, and pillars,
+      // numbered from musician_count.
+      blockers.Reset(a, grid_min, grid_max);
+      sightlines.Reset(a, grid_min, grid_max);
+      for(int k = 0; k < musician_count; k++)
+      {
+         if( k == m )
+            continue;
+         const XY &q = positions_[k];
+         const double angle = blockers.Angle(q);
+         blockers.Add(k, angle,
+                      HalfWidth(kScoreBlockingRadius,
+                                std::hypot(q.x - a.x, q.y - a.y)));
+
+         const int offset = k * attendee_count_ + j;
+         if( pillar_blocked_[offset] || volumes_[k] == 0 )
+            continue;
+         const bool blocked_by_m =
+            SegmentBlocked(a, q, p, kScoreBlockingRadius);
+         if( blocker_count_[offset] != (blocked_by_m ? 1 : 0) )
+            continue;
+         if( neighbor_index[k] >= 0 )
+         {
+            sightline_score[k] = base_[offset];
+            neighbor_visible[neighbor_index[k]] += base_[offset];
+         }
+         else
+         {
+            sightline_score[k] = PairContribution(k, j);
+            if( blocked_by_m )
+               unblocked += sightline_score[k];
+         }
+         sightlines.Add(k, angle, 0);
+      }
+      for(int i = 0; i < pillar_count; i++)
+      {
+         const XY &q = tables_.pillars[i];
+         blockers.Add(musician_count + i, blockers.Angle(q),
+                      HalfWidth(tables_.pillar_radius[i],
+                                std::hypot(q.x - a.x, q.y - a.y)));
+      }
+
+      for(int c = 0; c < cell_count; c++)
+      {
+         if( !available[c] )
+            continue;
+         const XY &v = cell_xy[c];
+         const double dx = a.x - v.x;
+         const double dy = a.y - v.y;
+         const double d2 = dx * dx + dy * dy;
+         const double angle = blockers.Angle(v);
+
+         double delta = 0;
+         if( taste != 0 && volume != 0 )
+         {
+            bool blocked = false;
+            for(int b : blockers.bin(blockers.Bin(angle)))
+            {
+               blocked = b < musician_count
+                  ? SegmentBlocked(a, v, positions_[b], kScoreBlockingRadius)
+                  : SegmentBlocked(a, v, tables_.pillars[b - musician_count],
+                                   tables_.pillar_radius[b - musician_count]);
+               if( blocked )
+                  break;
+            }
+            if( !blocked )
+            {
+               delta += std::ceil(std::ceil(1e6 * taste / d2) *
+                                  (volume * closeness[c]));
+            }
+         }
+
+         const double half_width =
+            HalfWidth(kScoreBlockingRadius, std::sqrt(d2));
+         const int end = sightlines.Bin(angle + half_width);
+         for(int b = sightlines.Bin(angle - half_width); b <= end; b++)
+         {
+            for(int k : sightlines.bin(b))
+            {
+               if( !SegmentBlocked(a, positions_[k], v, kScoreBlockingRadius) )
+                  continue;
+               if( neighbor_index[k] >= 0 )
+               {
+                  neighbor_blocked[neighbor_index[k] * cell_count + c] +=
+                     sightline_score[k];
+               }
+               else
+               {
+                  delta -= sightline_score[k];
+               }
+            }
+         }
+         (*deltas)[c] += delta;
+      }
+   }
+
+   // Rescore musicians of the same instrument with their new closeness
+   // factors.  Rounding is applied to the sum instead of each pair.
+   for(int i = 0; i < static_cast<int>(neighbors.size()); i++)
+   {
+      const int k = neighbors[i];
+      const XY &q = positions_[k];
+      const double old_inverse = 1 / std::hypot(p.x - q.x, p.y - q.y);
+      const double *blocked = neighbor_blocked.data() + i * cell_count;
+      for(int c = 0; c < cell_count; c++)
+      {
+         if( !available[c] )
+            continue;
+         const double new_closeness = closeness_[k] - old_inverse +
+            1 / std::hypot(cell_xy[c].x - q.x, cell_xy[c].y - q.y);
+         (*deltas)[c] +=
+            volumes_[k] * new_closeness * (neighbor_visible[i] - blocked[c]) -
+            contribution_[k];
+      }
+   }
+
+   for(int c = 0; c < cell_count; c++)
+   {
+      (*deltas)[c] = available[c]
+         ? (*deltas)[c] - contribution_[m] + unblocked
+         : -std::numeric_limits<double>::infinity();
+   }
+}
+
+double DeltaScorer::PairContribution(int m, int j) const
+{
+   return std::ceil(base_[m * attendee_count_ + j] *
+                    (volumes_[m] * closeness_[m]));
+}
+
+void DeltaScorer::UpdateContribution(int m)
+{
+   double sum = 0;
+   if( volumes_[m] != 0 )
+   {
+      for(int j = 0; j < attendee_count_; j++)
+      {
+         if( Visible(m, j) )
+            sum += PairContribution(m, j);
+      }
+   }
+   contribution_[m] = sum;
+}
+
+void DeltaScorer::UpdateSightLines(int m)
+{
+   const int musician_count = static_cast<int>(positions_.size());
+   const XY &p = positions_[m];
+   const int instrument = problem_.musicians()[m];
+   const bool has_pillars = !tables_.pillars.empty();
+   for(int j = 0; j < attendee_count_; j++)
+   {
+      const XY &a = tables_.attendees[j];
+      int count = 0;
+      for(int k = 0; k < musician_count; k++)
+      {
+         if( k != m &&
+             SegmentBlocked(a, p, positions_[k], kScoreBlockingRadius) )
+         {
+            count++;
+         }
+      }
+
+      const int offset = m * attendee_count_ + j;
+      blocker_count_[offset] = count;
+      pillar_blocked_[offset] =
+         has_pillars &&
+         ScoreCore<double, true, false, false>::BlockedByPillar(tables_, a, p);
+
+      const double dx = a.x - p.x;
+      const double dy = a.y - p.y;
+      base_[offset] = std::ceil(
+         1e6 * tables_.tastes[j * tables_.instrument_count + instrument] /
+         (dx * dx + dy * dy));
+   }
+}
+
+void DeltaScorer::UpdateBlockedMusicians(int m, const XY &old_position)
+{
+   const int musician_count = static_cast<int>(positions_.size());
+   const XY &new_position = positions_[m];
+   for(int k = 0; k < musician_count; k++)
+   {
+      if( k == m )
+         continue;
+
+      const XY &p = positions_[k];
+      int *count = blocker_count_.data() + k * attendee_count_;
+      double delta = 0;
+      for(int j = 0; j < attendee_count_; j++)
+      {
+         const XY &a = tables_.attendees[j];
+         const bool was_blocking =
+            SegmentBlocked(a, p, old_position, kScoreBlockingRadius);
+         const bool is_blocking =
+            SegmentBlocked(a, p, new_position, kScoreBlockingRadius);
+         if( was_blocking == is_blocking )
+            continue;
+
+         // Pair gains or loses visibility when blocker count goes
+         // between zero and one.
+         const bool was_visible = Visible(k, j);
+         count[j] += is_blocking ? 1 : -1;
+         if( was_visible != Visible(k, j) && volumes_[k] != 0 )
+         {
+            const double pair = PairContribution(k, j);
+            delta += was_visible ? -pair : pair;
+         }
+      }
+      contribution_[k] += delta;
+      score_ += delta;
+   }
+}
+
+void DeltaScorer::UpdateCloseness(int m)
+{
+   // Closeness factors are recomputed from scratch rather than adjusted
+   // incrementally, so that they match ComputeLimitedScore exactly.
+   const int musician_count = static_cast<int>(positions_.size());
+   const int instrument = problem_.musicians()[m];
+   for(int k = 0; k < musician_count; k++)
+   {
+      if( problem_.musicians()[k] != instrument )
+         continue;
+      closeness_[k] = ClosenessFactor(k);
+      if( k == m )
+         continue;
+      score_ -= contribution_[k];
+      UpdateContribution(k);
+      score_ += contribution_[k];
+   }
+}
+
+double DeltaScorer::ClosenessFactor(int m) const
+{
+   return ScoreCore<double, false, true, false>::ClosenessFactor(
+      positions_.data(),
+      problem_.musicians().data(),
+      static_cast<int>(positions_.size()),
+      m);
+}
@@ -0,0 +1,114 @@
+#ifndef DELTA_SCORE_H_
+#define DELTA_SCORE_H_
+
+#include<vector>
+#include"grid.h"
+#include"move_journal.h"
+#include"problem.h"
+
+// Maintain score incrementally as musicians move or change volume.
+//
+// For each musician and attendee pair, we keep the number of musicians
+// blocking that line of sight, so that moving one musician only needs to
+// check that musician against all other pairs, which is O(M*A) instead
+// of O(M*M*A) for a full rescore.  Changing volume costs O(A).
+//
+// Score matches ComputeLimitedScore with the same attendee count.
+class DeltaScorer
+{
+public:
+   DeltaScorer(const Problem &problem,
+               const std::vector<XY> &placements,
+               const std::vector<double> &volumes,
+               int attendee_count);
+
+   // Move a single musician to a new position.
+   void Move(int m, const XY &position);
+
+   // Swap positions of two musicians.
+   void Swap(int a, int b);
+
+   // Change volume for a single musician.
+   void SetVolume(int m, double volume);
+
+   // Apply or undo movements recorded in a journal.
+   void Apply(const std::vector<MoveJournal::Entry> &entries,
+              const Grid &grid);
+   void Undo(const std::vector<MoveJournal::Entry> &entries,
+             const Grid &grid);
+
+   // Compute score change of moving musician 'm' to each grid cell, with
+   // all other musicians fixed.  Output is indexed by Grid::ToIndex, with
+   // -infinity for cells within spacing distance of other musicians.
+   //
+   // Cells are scored together: for each attendee, other musicians and
+   // pillars are sorted into angular bins by the directions they block,
+   // and sightlines of other musicians by their direction, so each cell
+   // only checks blockers and sightlines in nearby bins.  This costs
+   // O(A*(M+C)) for C cells, instead of O(C*M*A) for moving to each cell.
+   //
+   // Deltas are exact without closeness extension.  With closeness, other
+   // musicians of the same instrument are rescored without rounding each
+   // pair, so their deltas may be off by up to one per attendee.
+   void MoveValues(int m, const Grid &grid, std::vector<double> *deltas) const;
+
+   // Check if attendee 'j' can see musician 'm'.
+   bool Visible(int m, int j) const
+   {
+      const int offset = m * attendee_count_ + j;
+      return blocker_count_[offset] == 0 && pillar_blocked_[offset] == 0;
+   }
+
+   double score() const { return score_; }
+   double contribution(int m) const { return contribution_[m]; }
+   double closeness(int m) const { return closeness_[m]; }
+   double volume(int m) const { return volumes_[m]; }
+   const XY &position(int m) const { return positions_[m]; }
+   int attendee_count() const { return attendee_count_; }
+   int musician_count() const { return static_cast<int>(positions_.size()); }
+
+   // Unscaled score for a visible pair, i.e. ceil(1e6*taste/d^2).
+   double base(int m, int j) const { return base_[m * attendee_count_ + j]; }
+
+private:
+   // Score of a single visible pair.
+   double PairContribution(int m, int j) const;
+
+   // Recompute contribution of a single musician from cached pair data.
+   void UpdateContribution(int m);
+
+   // Recompute blocker counts, pillar flags, and base scores for all
+   // attendees with respect to a single musician.
+   void UpdateSightLines(int m);
+
+   // Update blocker counts of other musicians after musician 'm' moved
+   // from 'old_position' to its current position.
+   void UpdateBlockedMusicians(int m, const XY &old_position);
+
+   // Update closeness factors after musician 'm' moved.
+   void UpdateCloseness(int m);
+
+   // Compute closeness factor for a single musician.
+   double ClosenessFactor(int m) const;
+
+   const Problem &problem_;
+   const ScoreTables<double> &tables_;
+   int attendee_count_;
+   bool use_closeness_;
+
+   std::vector<XY> positions_;
+   std::vector<double> volumes_;
+
+   // Per (musician * attendee_count + attendee) state.
+   std::vector<int> blocker_count_;
+   std::vector<char> pillar_blocked_;
+   std::vector<double> base_;
+
+   // Per musician state.
+   std::vector<double> closeness_;
+   std::vector<double> contribution_;
+
+   double score_;
+};
+
+#endif  // DELTA_SCORE_H_
@@ -0,0 +1,108 @@
+#include"elite_pool.h"
+
+#include<algorithm>
+
+ElitePool::ElitePool(const Problem &problem,
+                     const Grid &grid,
+                     int capacity,
+                     int min_distance)
+   : problem_(problem),
+     grid_(grid),
+     capacity_(capacity),
+     min_distance_(min_distance)
+{
+   elites_.reserve(capacity);
+}
+
+bool ElitePool::Offer(double score, const std::vector<Cell> &cells)
+{
+   Elite candidate;
+   candidate.score = score;
+   candidate.cells = cells;
+   candidate.keys.reserve(cells.size());
+   const int instrument_count =
+      static_cast<int>(problem_.instruments().size());
+   for(int m = 0; m < static_cast<int>(cells.size()); m++)
+   {
+      candidate.keys.push_back(
+         static_cast<long long>(grid_.ToIndex(cells[m])) * instrument_count +
+         problem_.musicians()[m]);
+   }
+   std::sort(candidate.keys.begin(), candidate.keys.end());
+
+   // If candidate is too close to an existing elite, it can only replace
+   // the nearest one.
+   int nearest = -1;
+   int nearest_distance = min_distance_;
+   for(int i = 0; i < size(); i++)
+   {
+      const int d = Distance(candidate, elites_[i]);
+      if( d < nearest_distance )
+      {
+         nearest = i;
+         nearest_distance = d;
+      }
+   }
+   if( nearest >= 0 )
+   {
+      if( elites_[nearest].score >= score )
+         return false;
+      elites_[nearest] = std::move(candidate);
+      return true;
+   }
+
+   if( size() < capacity_ )
+   {
+      elites_.push_back(std::move(candidate));
+      return true;
+   }
+
+   // Pool is full, replace the worst elite.
+   int worst = 0;
+   for(int i = 1; i < size(); i++)
+   {
+      if( elites_[i].score < elites_[worst].score )
+         worst = i;
+   }
+   if( elites_[worst].score >= score )
+      return false;
+   elites_[worst] = std::move(candidate);
+   return true;
+}
+
+int ElitePool::Distance(const Elite &a, const Elite &b)
+{
+   // Count keys in 'a' that are not in 'b' with a merge walk.
+   int distance = 0;
+   auto i = a.keys.begin();
+   auto j = b.keys.begin();
+   while( i != a.keys.end() )
+   {
+      if( j == b.keys.end() || *i < *j )
+      {
+         distance++;
+         ++i;
+      }
+      else if( *j < *i )
+      {
+         ++j;
+      }
+      else
+      {
+         ++i;
+         ++j;
+      }
+   }
+   return distance;
+}
+
+int ElitePool::best() const
+{
+   int best = 0;
+   for(int i = 1; i < size(); i++)
+   {
+      if( elites_[best].score < elites_[i].score )
+         best = i;
+   }
+   return best;
+}
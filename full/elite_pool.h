@@ -0,0 +1,59 @@
+#ifndef ELITE_POOL_H_
+#define ELITE_POOL_H_
+
+#include<vector>
+#include"grid.h"
+#include"problem.h"
+
+// Small set of the best distinct placements seen during a search.
+//
+// Distance between two placements is the Hamming distance between their
+// grids, with each occupied cell labelled by instrument: the number of
+// cells where the first placement has a musician that the second does
+// not have at the same cell with the same instrument.  Musicians of the
+// same instrument are interchangeable, so this is the minimum number of
+// musicians that would need to move to turn one placement into the other.
+//
+// Placements that are within 'min_distance' of an existing elite compete
+// with that elite instead of taking a new slot, so that the pool does not
+// fill up with copies of the same basin.
+class ElitePool
+{
+public:
+   struct Elite
+   {
+      double score;
+      std::vector<Cell> cells;
+
+      // Sorted list of (cell index, instrument) keys, for computing
+      // distances.
+      std::vector<long long> keys;
+   };
+
+   ElitePool(const Problem &problem,
+             const Grid &grid,
+             int capacity,
+             int min_distance);
+
+   // Add placements to pool if they are good enough and sufficiently
+   // different from existing elites.  Returns true if added.
+   bool Offer(double score, const std::vector<Cell> &cells);
+
+   // Distance between two elites.
+   static int Distance(const Elite &a, const Elite &b);
+
+   // Index of elite with highest score.  Pool must not be empty.
+   int best() const;
+
+   int size() const { return static_cast<int>(elites_.size()); }
+   const Elite &elite(int i) const { return elites_[i]; }
+
+private:
+   const Problem &problem_;
+   const Grid &grid_;
+   int capacity_;
+   int min_distance_;
+   std::vector<Elite> elites_;
+};
+
+#endif  // ELITE_POOL_H_
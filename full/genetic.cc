@@ -0,0 +1,271 @@
+#include"genetic.h"
+
+#include<memory>
+#include<vector>
+
+#include"delta_score.h"
+#include"elite_pool.h"
+
+namespace {
+
+// Number of placements in population.
+static constexpr int kPopulationSize = 16;
+
+// Minimum distance between population members, as a fraction of
+// musician count.
+static constexpr double kPopulationMinDistance = 0.05;
+
+// Number of free cells to consider when repairing a musician.
+static constexpr int kRepairCandidates = 4;
+
+// Probability of dropping a musician from a child, so that it gets
+// repaired onto a new cell.
+static constexpr double kMutationRate = 0.02;
+
+// Rebuild the scorer instead of moving musicians one at a time when more
+// than this fraction of musicians changed.  Each move costs O(M*A), and
+// a rebuild costs O(M^2*A), so moving is only cheaper for small diffs.
+static constexpr double kMaxIncrementalFraction = 0.25;
+
+// Snap a position to the nearest grid cell.  Returns false if that cell
+// is outside the grid.
+static bool SnapToGrid(const Grid &grid, const XY &p, Cell *cell)
+{
+   *cell = grid.FromXY(XY{p.x + Grid::kCellSize / 2,
+                          p.y + Grid::kCellSize / 2});
+   return grid.Contains(*cell);
+}
+
+// Take cells on one side of a random line from 'a', and cells on the
+// other side from 'b'.
+static void RegionCrossover(const Problem &problem,
+                            const Grid &grid,
+                            const std::vector<Cell> &a,
+                            const std::vector<Cell> &b,
+                            std::default_random_engine &rng,
+                            std::vector<Cell> *child,
+                            std::vector<char> *assigned)
+{
+   std::bernoulli_distribution coin(0.5);
+   const bool vertical = coin(rng);
+   const int extent = vertical ? grid.columns() : grid.rows();
+   std::uniform_int_distribution<> split_select(1, std::max(1, extent - 1));
+   const int split = split_select(rng);
+   const auto from_a = [vertical, split](const Cell &c)
+   {
+      return (vertical ? c.column : c.row) < split;
+   };
+
+   // Musicians keep their own cell from whichever parent owns it.
+   // Cells from 'b' that are not claimed this way are handed out to
+   // the remaining musicians of the same instrument.
+   const int musician_count = static_cast<int>(a.size());
+   std::vector<std::vector<Cell>> leftover(problem.instruments().size());
+   for(int m = 0; m < musician_count; m++)
+   {
+      (*assigned)[m] = 1;
+      if( from_a(a[m]) )
+      {
+         (*child)[m] = a[m];
+         if( !from_a(b[m]) )
+            leftover[problem.musicians()[m]].push_back(b[m]);
+      }
+      else if( !from_a(b[m]) )
+      {
+         (*child)[m] = b[m];
+      }
+      else
+      {
+         (*assigned)[m] = 0;
+      }
+   }
+   for(int m = 0; m < musician_count; m++)
+   {
+      std::vector<Cell> &cells = leftover[problem.musicians()[m]];
+      if( (*assigned)[m] == 0 && !cells.empty() )
+      {
+         (*child)[m] = cells.back();
+         cells.pop_back();
+         (*assigned)[m] = 1;
+      }
+   }
+}
+
+// Take cells for each instrument from a randomly selected parent.
+static void InstrumentCrossover(const Problem &problem,
+                                const std::vector<Cell> &a,
+                                const std::vector<Cell> &b,
+                                std::default_random_engine &rng,
+                                std::vector<Cell> *child,
+                                std::vector<char> *assigned)
+{
+   std::bernoulli_distribution coin(0.5);
+   std::vector<char> use_a(problem.instruments().size());
+   for(char &u : use_a)
+      u = coin(rng) ? 1 : 0;
+
+   for(int m = 0; m < static_cast<int>(a.size()); m++)
+   {
+      (*child)[m] = use_a[problem.musicians()[m]] ? a[m] : b[m];
+      (*assigned)[m] = 1;
+   }
+}
+
+// Replace journal placements with child placements.  Musicians that are
+// unassigned or collide with an earlier musician are moved to the best
+// of a few free cells.  Returns number of repaired musicians.
+static int PlaceChild(const Problem &problem,
+                      const CellValues &values,
+                      const std::vector<Cell> &child,
+                      const std::vector<char> &assigned,
+                      MoveJournal *journal)
+{
+   Grid *grid = journal->grid();
+   for(const Cell &c : journal->cells())
+      grid->Set(c, 0);
+
+   std::vector<int> unplaced;
+   for(int m = 0; m < static_cast<int>(child.size()); m++)
+   {
+      if( assigned[m] != 0 && grid->Get(child[m]) == 0 )
+      {
+         journal->Place(m, child[m]);
+      }
+      else
+      {
+         unplaced.push_back(m);
+      }
+   }
+
+   for(int m : unplaced)
+   {
+      const int instrument = problem.musicians()[m];
+      Cell best = grid->RandomFreeCell();
+      for(int i = 1; i < kRepairCandidates; i++)
+      {
+         const Cell c = grid->RandomFreeCell();
+         if( values.PillarAwareValue(best, instrument) <
+             values.PillarAwareValue(c, instrument) )
+         {
+            best = c;
+         }
+      }
+      journal->Place(m, best);
+   }
+   return static_cast<int>(unplaced.size());
+}
+
+// Update scorer to match journal placements.  If few musicians changed,
+// only those are moved, otherwise the scorer is rebuilt.  Musicians may
+// briefly share a position while moving, which DeltaScorer tolerates.
+static void SyncScorer(const Problem &problem,
+                       const MoveJournal &journal,
+                       const std::vector<double> &volumes,
+                       std::unique_ptr<DeltaScorer> *scorer)
+{
+   const std::vector<XY> &placements = journal.placements();
+   const int musician_count = static_cast<int>(placements.size());
+   std::vector<int> changed;
+   for(int m = 0; m < musician_count; m++)
+   {
+      const XY &p = (*scorer)->position(m);
+      if( p.x != placements[m].x || p.y != placements[m].y )
+         changed.push_back(m);
+   }
+
+   if( changed.size() > musician_count * kMaxIncrementalFraction )
+   {
+      const int attendee_count = (*scorer)->attendee_count();
+      scorer->reset(
+         new DeltaScorer(problem, placements, volumes, attendee_count));
+      return;
+   }
+   for(int m : changed)
+      (*scorer)->Move(m, placements[m]);
+}
+
+}  // namespace
+
+void Evolve(const Problem &problem,
+            const SolveOptions &options,
+            const CellValues &values,
+            int attendee_count,
+            std::chrono::steady_clock::duration duration,
+            MoveJournal *journal,
+            std::default_random_engine &rng,
+            Solution *solution)
+{
+   const auto start_time = std::chrono::steady_clock::now();
+   const int musician_count = static_cast<int>(problem.musicians().size());
+   const Grid &grid = *journal->grid();
+   ElitePool population(problem, grid, kPopulationSize,
+                        std::max(1, static_cast<int>(
+                           musician_count * kPopulationMinDistance)));
+   std::unique_ptr<DeltaScorer> scorer(new DeltaScorer(
+      problem, journal->placements(), solution->volumes, attendee_count));
+   population.Offer(scorer->score(), journal->cells());
+
+   // Add seed placements.
+   std::vector<Cell> child(musician_count);
+   std::vector<char> assigned(musician_count);
+   for(const std::vector<XY> &seed : options.seeds)
+   {
+      for(int m = 0; m < musician_count; m++)
+         assigned[m] = SnapToGrid(grid, seed[m], &child[m]) ? 1 : 0;
+      solution->counters[Solution::kCrossoverRepairs] +=
+         PlaceChild(problem, values, child, assigned, journal);
+      SyncScorer(problem, *journal, solution->volumes, &scorer);
+      population.Offer(scorer->score(), journal->cells());
+   }
+
+   // Fill the rest of the population with random placements.
+   std::fill(assigned.begin(), assigned.end(), 0);
+   for(int i = population.size();
+       i < kPopulationSize &&
+       std::chrono::steady_clock::now() - start_time < duration;
+       i++)
+   {
+      PlaceChild(problem, values, child, assigned, journal);
+      SyncScorer(problem, *journal, solution->volumes, &scorer);
+      population.Offer(scorer->score(), journal->cells());
+   }
+
+   std::bernoulli_distribution coin(0.5);
+   std::bernoulli_distribution mutate(kMutationRate);
+   while( population.size() > 1 &&
+          std::chrono::steady_clock::now() - start_time < duration )
+   {
+      // Select two distinct parents.
+      std::uniform_int_distribution<> parent_select(0, population.size() - 1);
+      const int a = parent_select(rng);
+      int b = parent_select(rng);
+      while( b == a )
+         b = parent_select(rng);
+
+      if( coin(rng) )
+      {
+         RegionCrossover(problem, grid, population.elite(a).cells,
+                         population.elite(b).cells, rng, &child, &assigned);
+      }
+      else
+      {
+         InstrumentCrossover(problem, population.elite(a).cells,
+                             population.elite(b).cells, rng, &child,
+                             &assigned);
+      }
+      for(char &c : assigned)
+      {
+         if( mutate(rng) )
+            c = 0;
+      }
+
+      solution->counters[Solution::kCrossovers]++;
+      solution->counters[Solution::kCrossoverRepairs] +=
+         PlaceChild(problem, values, child, assigned, journal);
+      SyncScorer(problem, *journal, solution->volumes, &scorer);
+      if( population.Offer(scorer->score(), journal->cells()) )
+         solution->counters[Solution::kCrossoverAccepted]++;
+   }
+
+   journal->Restore(population.elite(population.best()).cells);
+}
@@ -0,0 +1,41 @@
+#ifndef GENETIC_H_
+#define GENETIC_H_
+
+#include<chrono>
+#include<random>
+#include"cell_values.h"
+#include"move_journal.h"
+#include"problem.h"
+#include"solution.h"
+
+// Improve placements by recombining a population of placements.
+//
+// Population is seeded with the journal's current placements, any
+// placements in options.seeds (snapped to the grid), and random fill.
+// Each generation picks two parents and builds a child by one of:
+//
+// - Region crossover: cells on one side of a random vertical or
+//   horizontal line come from the first parent, cells on the other side
+//   come from the second.  Musicians of the same instrument are
+//   interchangeable, so cells are handed out per instrument.
+//
+// - Instrument crossover: all musicians of each instrument take their
+//   cells from a randomly chosen parent.
+//
+// Collisions and unassigned musicians are repaired by placing them on
+// the best of a few free cells.  Children are scored with DeltaScorer,
+// moving only musicians that differ from the previous candidate, and
+// kept in an ElitePool of distinct placements.
+//
+// 'journal' must be in committed state on entry.  On return, it holds the
+// best placements in the population.
+void Evolve(const Problem &problem,
+            const SolveOptions &options,
+            const CellValues &values,
+            int attendee_count,
+            std::chrono::steady_clock::duration duration,
+            MoveJournal *journal,
+            std::default_random_engine &rng,
+            Solution *solution);
+
+#endif  // GENETIC_H_
@@ -24,22 +24,17 @@ Grid::Grid(const Problem &problem) : rng_(rd_())
    for(int i = 0; i < height; i++)
       grid_.push_back(std::string(width, '\0'));
 
-   points_.reserve(width * height);
-   for(int x = 0; x < width; x++)
-   {
-      for(int y = 0; y < height; y++)
-         points_.push_back(std::make_pair(x, y));
-   }
-   ShufflePoints();
-}
-
-void Grid::ShufflePoints()
-{
-   std::shuffle(points_.begin(), points_.end(), rng_);
+   free_cells_.reserve(width * height);
+   free_slot_.resize(width * height);
+   Reset();
 }
 
 void Grid::Reset()
 {
    for(std::string &row : grid_)
       std::fill(row.begin(), row.end(), '\0');
+
+   free_cells_.clear();
+   for(int i = 0; i < static_cast<int>(free_slot_.size()); i++)
+      AddFreeCell(i);
 }
@@ -1,12 +1,26 @@
 #ifndef GRID_H_
 #define GRID_H_
 
+#include<stdint.h>
+
 #include<random>
 #include<string>
-#include<utility>
 #include<vector>
 #include"problem.h"
 
+// Packed (column, row) grid coordinate.  Search code carries musician
+// positions in this form, and only converts to XY for scoring and output.
+struct Cell
+{
+   int16_t column, row;
+};
+
+inline bool operator==(const Cell &a, const Cell &b)
+{
+   return a.column == b.column && a.row == b.row;
+}
+inline bool operator!=(const Cell &a, const Cell &b) { return !(a == b); }
+
 class Grid
 {
 public:
@@ -15,59 +29,103 @@ public:
    // Initialize empty grid.
    explicit Grid(const Problem &problem);
 
-   // Shuffle points_.
-   void ShufflePoints();
-
    // Reset grid cells to all zeroes.
    void Reset();
 
    // Convert (column, row) indices.
-   std::pair<int, int> FromXY(const XY &p) const
+   Cell FromXY(const XY &p) const
    {
-      return std::make_pair(static_cast<int>((p.x - min_.x) / kCellSize),
-                            static_cast<int>((p.y - min_.y) / kCellSize));
+      return MakeCell(static_cast<int>((p.x - min_.x) / kCellSize),
+                      static_cast<int>((p.y - min_.y) / kCellSize));
    }
    XY ToXY(int column, int row) const
    {
       return {min_.x + column * kCellSize, min_.y + row * kCellSize};
    }
+   XY ToXY(const Cell &c) const { return ToXY(c.column, c.row); }
+   static Cell MakeCell(int column, int row)
+   {
+      return Cell{static_cast<int16_t>(column), static_cast<int16_t>(row)};
+   }
 
-   // Write grid cells.
-   void Set(int column, int row, int state)
+   // Convert between cells and linear indices (row * columns + column).
+   int ToIndex(const Cell &c) const { return c.row * columns() + c.column; }
+   Cell FromIndex(int index) const
+   {
+      return MakeCell(index % columns(), index / columns());
+   }
+
+   // Check if cell is within grid bounds.
+   bool Contains(const Cell &c) const
    {
-      grid_[row][column] = static_cast<char>(state);
+      return c.column >= 0 && c.column < columns() &&
+             c.row >= 0 && c.row < rows();
    }
-   void Set(const XY &p, int state)
+
+   // Write grid cells.
+   void Set(int column, int row, int state)
    {
-      Set(static_cast<int>((p.x - min_.x) / kCellSize),
-          static_cast<int>((p.y - min_.y) / kCellSize),
-          state);
+      char &cell = grid_[row][column];
+      if( (cell == 0) != (state == 0) )
+      {
+         if( state == 0 )
+            AddFreeCell(row * columns() + column);
+         else
+            RemoveFreeCell(row * columns() + column);
+      }
+      cell = static_cast<char>(state);
    }
+   void Set(const Cell &c, int state) { Set(c.column, c.row, state); }
 
    // Read grid cells.
    int Get(int column, int row) const
    {
       return static_cast<int>(grid_[row][column]);
    }
-   int Get(const XY &p) const
+   int Get(const Cell &c) const { return Get(c.column, c.row); }
+
+   // Return a uniformly random unoccupied cell.  Caller must make sure
+   // that there is at least one free cell.
+   Cell RandomFreeCell()
    {
-      return Get(static_cast<int>((p.x - min_.x) / kCellSize),
-                 static_cast<int>((p.y - min_.y) / kCellSize));
+      std::uniform_int_distribution<int> select(0, free_count() - 1);
+      return FromIndex(free_cells_[select(rng_)]);
    }
 
    int rows() const { return static_cast<int>(grid_.size()); }
    int columns() const { return static_cast<int>(grid_.front().size()); }
-   const std::vector<std::pair<int, int>> &points() const { return points_; }
+   int free_count() const { return static_cast<int>(free_cells_.size()); }
 
 private:
+   // Maintain free cell index.
+   void AddFreeCell(int cell)
+   {
+      free_slot_[cell] = static_cast<int>(free_cells_.size());
+      free_cells_.push_back(cell);
+   }
+   void RemoveFreeCell(int cell)
+   {
+      const int slot = free_slot_[cell];
+      const int last = free_cells_.back();
+      free_cells_[slot] = last;
+      free_slot_[last] = slot;
+      free_cells_.pop_back();
+      free_slot_[cell] = -1;
+   }
+
    // Keep track of which cells are occupied.
    std::vector<std::string> grid_;
 
    // Lower left corner position.
    XY min_;
 
-   // List of shuffled (column, row) values.
-   std::vector<std::pair<int, int>> points_;
+   // List of unoccupied cells (row * columns + column), in no particular
+   // order.  Cells are removed by swapping with the last entry, so
+   // insertion and removal are both O(1).
+   std::vector<int> free_cells_;
+
+   // Index into free_cells_ for each cell, or -1 if cell is occupied.
+   std::vector<int> free_slot_;
 
    // Random state.
    std::random_device rd_;
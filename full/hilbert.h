@@ -0,0 +1,45 @@
+#ifndef HILBERT_H_
+#define HILBERT_H_
+
+#include<stdint.h>
+
+#include<algorithm>
+
+// Map (x, y) in [0, 65536) to distance along a Hilbert curve that covers
+// that square.  Points that are close along the curve are also close in
+// space, so sorting by this index improves locality.
+inline uint32_t HilbertIndex(uint32_t x, uint32_t y)
+{
+   static constexpr uint32_t kSize = 1 << 16;
+
+   uint32_t d = 0;
+   for(uint32_t s = kSize / 2; s > 0; s /= 2)
+   {
+      const uint32_t rx = (x & s) != 0 ? 1 : 0;
+      const uint32_t ry = (y & s) != 0 ? 1 : 0;
+      d += s * s * ((3 * rx) ^ ry);
+
+      // Rotate quadrant.
+      if( ry == 0 )
+      {
+         if( rx == 1 )
+         {
+            x = kSize - 1 - x;
+            y = kSize - 1 - y;
+         }
+         std::swap(x, y);
+      }
+   }
+   return d;
+}
+
+// Compute Hilbert index for a point within a rectangle of size (w, h).
+inline uint32_t HilbertIndex(double x, double y, double w, double h)
+{
+   const double scale = 65535.0 / std::max(w, h);
+   return HilbertIndex(
+      static_cast<uint32_t>(std::clamp(x * scale, 0.0, 65535.0)),
+      static_cast<uint32_t>(std::clamp(y * scale, 0.0, 65535.0)));
+}
+
+#endif  // HILBERT_H_
@@ -1,10 +1,9 @@
 #ifndef INTERSECT_H_
 #define INTERSECT_H_
 
-struct XY
-{
-   double x, y;
-};
+#include"score_core.h"
+
+using XY = ScorePoint<double>;
 
 // Check if a line segment from u to v would intersect blocker of a particular
 // radius.  Returns true if so.
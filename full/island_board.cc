@@ -0,0 +1,107 @@
+#include"island_board.h"
+
+#include<limits>
+
+namespace {
+
+static unsigned int PackCell(const Cell &c)
+{
+   return (static_cast<unsigned int>(static_cast<uint16_t>(c.column)) << 16) |
+          static_cast<uint16_t>(c.row);
+}
+
+static Cell UnpackCell(unsigned int packed)
+{
+   return Grid::MakeCell(static_cast<int16_t>(packed >> 16),
+                         static_cast<int16_t>(packed & 0xffff));
+}
+
+}  // namespace
+
+IslandBoard::IslandBoard(int island_count, int musician_count)
+   : island_count_(island_count),
+     musician_count_(musician_count),
+     slots_(new Slot[island_count])
+{
+   for(int i = 0; i < island_count; i++)
+   {
+      slots_[i].score.store(-std::numeric_limits<double>::infinity());
+      slots_[i].cells.reset(new std::atomic<unsigned int>[musician_count]);
+      slots_[i].volumes.reset(new std::atomic<double>[musician_count]);
+      for(int m = 0; m < musician_count; m++)
+      {
+         slots_[i].cells[m].store(0);
+         slots_[i].volumes[m].store(0);
+      }
+   }
+}
+
+bool IslandBoard::Publish(int island,
+                          double score,
+                          const std::vector<Cell> &cells,
+                          const std::vector<double> &volumes)
+{
+   // Each slot has only one writer, so this check does not race with
+   // other writes.
+   Slot &slot = slots_[island];
+   if( !(slot.score.load(std::memory_order_relaxed) < score) )
+      return false;
+
+   const unsigned int sequence =
+      slot.sequence.load(std::memory_order_relaxed);
+   slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+   for(int m = 0; m < musician_count_; m++)
+   {
+      slot.cells[m].store(PackCell(cells[m]), std::memory_order_relaxed);
+      slot.volumes[m].store(volumes[m], std::memory_order_relaxed);
+   }
+   slot.score.store(score, std::memory_order_relaxed);
+   slot.sequence.store(sequence + 2, std::memory_order_release);
+   return true;
+}
+
+int IslandBoard::BestIsland() const
+{
+   std::vector<Cell> cells;
+   std::vector<double> volumes;
+   int best = -1;
+   double best_score = -std::numeric_limits<double>::infinity();
+   for(int i = 0; i < island_count_; i++)
+   {
+      const double score = Read(i, &cells, &volumes);
+      if( best_score < score )
+      {
+         best = i;
+         best_score = score;
+      }
+   }
+   return best;
+}
+
+double IslandBoard::Read(int island,
+                         std::vector<Cell> *cells,
+                         std::vector<double> *volumes) const
+{
+   const Slot &slot = slots_[island];
+   cells->resize(musician_count_);
+   volumes->resize(musician_count_);
+   for(;;)
+   {
+      const unsigned int before =
+         slot.sequence.load(std::memory_order_acquire);
+      if( before & 1 )
+         continue;
+
+      for(int m = 0; m < musician_count_; m++)
+      {
+         (*cells)[m] =
+            UnpackCell(slot.cells[m].load(std::memory_order_relaxed));
+         (*volumes)[m] = slot.volumes[m].load(std::memory_order_relaxed);
+      }
+      const double score = slot.score.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if( slot.sequence.load(std::memory_order_relaxed) == before )
+         return score;
+   }
+}
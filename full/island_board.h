@@ -0,0 +1,60 @@
+#ifndef ISLAND_BOARD_H_
+#define ISLAND_BOARD_H_
+
+#include<atomic>
+#include<memory>
+#include<vector>
+#include"grid.h"
+
+// Lock-free exchange of placements and volumes between search threads.
+//
+// Each island owns one slot and is the only writer to that slot, so
+// writers never contend.  Slots are guarded by sequence locks: writer
+// bumps the sequence to an odd value, stores cells, then bumps it to the
+// next even value.  Readers retry if the sequence was odd or changed
+// while they were copying.  Cells and volumes are stored as relaxed
+// atomics, so that a torn read is detected and discarded rather than
+// undefined.  Volumes are kept with cells since search may mute
+// musicians, and a score is only meaningful for the pair.
+class IslandBoard
+{
+public:
+   IslandBoard(int island_count, int musician_count);
+
+   // Publish placements and volumes for an island, if they are better
+   // than what the island published previously.  Returns true if they
+   // were stored.
+   bool Publish(int island,
+                double score,
+                const std::vector<Cell> &cells,
+                const std::vector<double> &volumes);
+
+   // Copy the latest placements and volumes published by an island.
+   // Returns score of those placements, or -infinity if the island has not
+   // published yet.
+   double Read(int island,
+               std::vector<Cell> *cells,
+               std::vector<double> *volumes) const;
+
+   // Index of island with best published score, or -1 if nothing has
+   // been published yet.  Islands may still be publishing, so the result
+   // is only final once all writers have stopped.
+   int BestIsland() const;
+
+   int island_count() const { return island_count_; }
+
+private:
+   struct Slot
+   {
+      std::atomic<unsigned int> sequence{0};
+      std::atomic<double> score;
+      std::unique_ptr<std::atomic<unsigned int>[]> cells;
+      std::unique_ptr<std::atomic<double>[]> volumes;
+   };
+
+   int island_count_;
+   int musician_count_;
+   std::unique_ptr<Slot[]> slots_;
+};
+
+#endif  // ISLAND_BOARD_H_
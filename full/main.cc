@@ -1,4 +1,6 @@
 #include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
 
 #include<array>
 #include<sstream>
@@ -259,16 +261,227 @@ static void OutputVisualization(const Problem &problem,
            counters.c_str());
 }
 
+// Parse leading command line flags.  Returns number of arguments
+// consumed, or -1 on error.
+static int ParseOptions(int argc, char **argv, SolveOptions *options)
+{
+   int i = 1;
+   for(; i < argc && strncmp(argv[i], "--", 2) == 0; i++)
+   {
+      if( strcmp(argv[i], "--spatial-order") == 0 )
+      {
+         options->spatial_order = true;
+      }
+      else if( strcmp(argv[i], "--float-scorer") == 0 )
+      {
+         options->float_scorer = true;
+      }
+      else if( strcmp(argv[i], "--value-proposals") == 0 )
+      {
+         options->value_proposals = true;
+      }
+      else if( strcmp(argv[i], "--cascade") == 0 )
+      {
+         options->cascade = true;
+      }
+      else if( strncmp(argv[i], "--cascade-tolerance=", 20) == 0 )
+      {
+         options->cascade_tolerance = atof(argv[i] + 20);
+         if( !(options->cascade_tolerance >= 0) )
+         {
+            fprintf(stderr, "Tolerance must be non-negative: %s\n", argv[i]);
+            return -1;
+         }
+      }
+      else if( strcmp(argv[i], "--anneal") == 0 )
+      {
+         options->anneal = true;
+      }
+      else if( strncmp(argv[i], "--anneal-acceptance=", 20) == 0 )
+      {
+         options->anneal_acceptance = atof(argv[i] + 20);
+         if( !(options->anneal_acceptance > 0 &&
+               options->anneal_acceptance < 1) )
+         {
+            fprintf(stderr, "Acceptance must be in (0, 1): %s\n", argv[i]);
+            return -1;
+         }
+      }
+      else if( strncmp(argv[i], "--anneal-final-ratio=", 21) == 0 )
+      {
+         options->anneal_final_ratio = atof(argv[i] + 21);
+         if( !(options->anneal_final_ratio > 0 &&
+               options->anneal_final_ratio <= 1) )
+         {
+            fprintf(stderr, "Final ratio must be in (0, 1]: %s\n", argv[i]);
+            return -1;
+         }
+      }
+      else if( strncmp(argv[i], "--anneal-levels=", 16) == 0 )
+      {
+         options->anneal_levels = atoi(argv[i] + 16);
+         if( options->anneal_levels < 1 )
+         {
+            fprintf(stderr, "Level count must be positive: %s\n", argv[i]);
+            return -1;
+         }
+      }
+      else if( strncmp(argv[i], "--islands=", 10) == 0 )
+      {
+         options->islands = atoi(argv[i] + 10);
+         if( options->islands < 1 )
+         {
+            fprintf(stderr, "Island count must be positive: %s\n", argv[i]);
+            return -1;
+         }
+      }
+      else if( strncmp(argv[i], "--tiles=", 8) == 0 )
+      {
+         options->tiles = atoi(argv[i] + 8);
+         if( options->tiles < 1 )
+         {
+            fprintf(stderr, "Tile count must be positive: %s\n", argv[i]);
+            return -1;
+         }
+      }
+      else if( strncmp(argv[i], "--transpositions=", 17) == 0 )
+      {
+         options->transpositions = atoi(argv[i] + 17);
+         if( options->transpositions < 0 )
+         {
+            fprintf(stderr, "Table size must not be negative: %s\n",
+                    argv[i]);
+            return -1;
+         }
+      }
+      else if( strcmp(argv[i], "--assignment") == 0 )
+      {
+         options->assignment = true;
+      }
+      else if( strcmp(argv[i], "--blockers") == 0 )
+      {
+         options->blockers = true;
+      }
+      else if( strcmp(argv[i], "--mute-moves") == 0 )
+      {
+         options->mute_moves = true;
+      }
+      else if( strcmp(argv[i], "--polish") == 0 )
+      {
+         options->polish = true;
+      }
+      else if( strcmp(argv[i], "--relocate") == 0 )
+      {
+         options->relocate = true;
+      }
+      else if( strncmp(argv[i], "--partition=", 12) == 0 )
+      {
+         static const char *const kPartitionNames[] =
+         {
+            "random", "spatial", "instrument", "attendee", "mixed"
+         };
+         int p = 0;
+         while( p <= SolveOptions::kMixedPartition &&
+                strcmp(argv[i] + 12, kPartitionNames[p]) != 0 )
+         {
+            p++;
+         }
+         if( p > SolveOptions::kMixedPartition )
+         {
+            fprintf(stderr, "Unrecognized partition: %s\n", argv[i]);
+            return -1;
+         }
+         options->partition = static_cast<SolveOptions::Partition>(p);
+      }
+      else if( strcmp(argv[i], "--genetic") == 0 )
+      {
+         options->genetic = true;
+      }
+      else if( strncmp(argv[i], "--seed=", 7) == 0 )
+      {
+         Solution seed;
+         LoadSolutionFromText(LoadText(argv[i] + 7), &seed);
+         if( seed.placements.empty() )
+         {
+            fprintf(stderr, "Failed to load seed: %s\n", argv[i] + 7);
+            return -1;
+         }
+         options->seeds.push_back(seed.placements);
+      }
+      else
+      {
+         fprintf(stderr, "Unrecognized option: %s\n", argv[i]);
+         return -1;
+      }
+   }
+   if( options->anneal && options->genetic )
+   {
+      fputs("--anneal and --genetic are mutually exclusive\n", stderr);
+      return -1;
+   }
+   if( options->mute_moves && !options->anneal )
+   {
+      fputs("--mute-moves requires --anneal\n", stderr);
+      return -1;
+   }
+   return i - 1;
+}
+
 }  // namespace
 
 int main(int argc, char **argv)
 {
-   if( argc != 4 && argc != 5 )
+   SolveOptions options;
+   const int option_count = ParseOptions(argc, argv, &options);
+   if( option_count < 0 ||
+       (argc - option_count != 4 && argc - option_count != 5) )
    {
       return fprintf(stderr,
-                     "%s {input.json} {output.json} {output.svg} [old.json]\n",
+                     "%s [options] {input.json} {output.json} {output.svg} "
+                     "[old.json]\n\n"
+                     "options:\n"
+                     "  --spatial-order = sort attendees and musicians along "
+                     "a Hilbert curve\n"
+                     "  --float-scorer = rank search candidates with single "
+                     "precision scores\n"
+                     "  --value-proposals = move musicians to cells in "
+                     "proportion to cell values\n"
+                     "  --cascade = screen candidates with a blocking-free "
+                     "surrogate score\n"
+                     "  --cascade-tolerance={t} = relative surrogate loss "
+                     "allowed before rejecting\n"
+                     "  --anneal = search with simulated annealing\n"
+                     "  --anneal-acceptance={p} = initial acceptance "
+                     "probability for worsening moves\n"
+                     "  --anneal-final-ratio={r} = final temperature relative "
+                     "to initial temperature\n"
+                     "  --anneal-levels={n} = number of temperature levels\n"
+                     "  --islands={n} = run {n} search threads that exchange "
+                     "best placements\n"
+                     "     (annealing restarts cooling at each exchange)\n"
+                     "  --tiles={n} = split stage into {n} tiles searched "
+                     "in parallel\n"
+                     "  --transpositions={n} = cache random dance scores in "
+                     "{n} slots\n"
+                     "  --assignment = periodically reassign instruments to "
+                     "occupied cells\n"
+                     "  --blockers = mute useless musicians and place them "
+                     "to block hated sightlines\n"
+                     "  --mute-moves = toggle musician volumes during "
+                     "annealing\n"
+                     "  --polish = refine placements off the grid after "
+                     "search\n"
+                     "  --relocate = move musicians to best cells when "
+                     "upgrading old.json\n"
+                     "  --partition={random|spatial|instrument|attendee|mixed}"
+                     " = how random dance groups musicians\n"
+                     "  --genetic = search by crossover of placements\n"
+                     "  --seed={solution.json} = add placements to genetic "
+                     "population (repeatable)\n",
                      *argv);
    }
+   argc -= option_count;
+   argv += option_count;
 
    Problem problem(LoadText(argv[1]));
    if( !problem.valid() )
@@ -276,17 +489,27 @@ int main(int argc, char **argv)
       fprintf(stderr, "%s is invalid\n", argv[1]);
       return 1;
    }
+   PrepareProblem(options, &problem);
+   for(const std::vector<XY> &seed : options.seeds)
+   {
+      if( seed.size() != problem.musicians().size() )
+      {
+         fprintf(stderr, "Seed has %zu placements, expected %zu\n",
+                 seed.size(), problem.musicians().size());
+         return 1;
+      }
+   }
 
    Solution solution;
    if( argc == 5 )
    {
       LoadSolutionFromText(LoadText(argv[4]), &solution);
-      if( !UpgradeSolution(problem, &solution) )
+      if( !UpgradeSolution(problem, options, &solution) )
          return 1;
    }
    else
    {
-      Solve(problem, &solution);
+      Solve(problem, options, &solution);
    }
 
    FILE *outfile = fopen(argv[2], "wb");
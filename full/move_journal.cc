@@ -0,0 +1,175 @@
+#include"move_journal.h"
+
+#include<unordered_map>
+
+namespace {
+
+// Convert placement to single precision.
+static ScorePoint<float> ToFloat(const XY &p)
+{
+   return ScorePoint<float>{static_cast<float>(p.x), static_cast<float>(p.y)};
+}
+
+}  // namespace
+
+MoveJournal::MoveJournal(Grid *grid,
+                         std::vector<Cell> *cells,
+                         std::vector<XY> *placements)
+   : grid_(grid), cells_(cells), placements_(placements)
+{
+   for(int m = 0; m < static_cast<int>(cells->size()); m++)
+      hash_ ^= Key(m, (*cells)[m]);
+}
+
+uint64_t MoveJournal::Key(int m, const Cell &cell) const
+{
+   // SplitMix64 finalizer.
+   uint64_t x = (static_cast<uint64_t>(m) << 32) |
+                static_cast<uint32_t>(grid_->ToIndex(cell));
+   x += 0x9e3779b97f4a7c15ULL;
+   x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+   return x ^ (x >> 31);
+}
+
+void MoveJournal::Place(int m, const Cell &cell)
+{
+   hash_ ^= Key(m, (*cells_)[m]) ^ Key(m, cell);
+   grid_->Set(cell, 1);
+   (*cells_)[m] = cell;
+   (*placements_)[m] = grid_->ToXY(cell);
+   if( float_placements_ != nullptr )
+      (*float_placements_)[m] = ToFloat((*placements_)[m]);
+}
+
+void MoveJournal::set_float_placements(
+   std::vector<ScorePoint<float>> *placements)
+{
+   float_placements_ = placements;
+   if( placements == nullptr )
+      return;
+   placements->resize(placements_->size());
+   for(int m = 0; m < static_cast<int>(placements_->size()); m++)
+      (*placements)[m] = ToFloat((*placements_)[m]);
+}
+
+void MoveJournal::Move(int m, const Cell &cell)
+{
+   const Cell from = (*cells_)[m];
+   grid_->Set(from, 0);
+   Place(m, cell);
+   entries_.push_back(Entry{m, from, cell});
+}
+
+void MoveJournal::Swap(int a, int b)
+{
+   const Cell cell_a = (*cells_)[a];
+   const Cell cell_b = (*cells_)[b];
+   Place(a, cell_b);
+   Place(b, cell_a);
+   entries_.push_back(Entry{a, cell_a, cell_b, b});
+}
+
+int MoveJournal::MoveGroup(const std::vector<int> &musicians,
+                           const std::vector<Cell> &targets)
+{
+   const int count = static_cast<int>(musicians.size());
+   std::unordered_map<int, int> group_index;
+   for(int i = 0; i < count; i++)
+      group_index[grid_->ToIndex((*cells_)[musicians[i]])] = i;
+
+   // Find members that can move, dropping members that are blocked by
+   // non-moving musicians until there are no more changes.
+   std::vector<char> moving(count);
+   for(int i = 0; i < count; i++)
+   {
+      moving[i] = grid_->Contains(targets[i]) &&
+                  targets[i] != (*cells_)[musicians[i]];
+   }
+   for(bool changed = true; changed;)
+   {
+      changed = false;
+      for(int i = 0; i < count; i++)
+      {
+         if( !moving[i] || grid_->Get(targets[i]) == 0 )
+            continue;
+         const auto owner = group_index.find(grid_->ToIndex(targets[i]));
+         if( owner == group_index.end() || !moving[owner->second] )
+         {
+            moving[i] = 0;
+            changed = true;
+         }
+      }
+   }
+
+   // Move members whose targets are free.  If none of the remaining
+   // members can move, they form cycles, so move one of them out of the
+   // way to break the cycle.
+   std::vector<int> pending;
+   for(int i = 0; i < count; i++)
+   {
+      if( moving[i] )
+         pending.push_back(i);
+   }
+   const int moved = static_cast<int>(pending.size());
+   while( !pending.empty() )
+   {
+      int remaining = 0;
+      for(int i : pending)
+      {
+         if( grid_->Get(targets[i]) == 0 )
+         {
+            Move(musicians[i], targets[i]);
+         }
+         else
+         {
+            pending[remaining++] = i;
+         }
+      }
+      if( remaining == static_cast<int>(pending.size()) )
+         Move(musicians[pending.front()], grid_->RandomFreeCell());
+      pending.resize(remaining);
+   }
+   return moved;
+}
+
+void MoveJournal::Restore(const std::vector<Cell> &cells)
+{
+   for(const Cell &c : *cells_)
+      grid_->Set(c, 0);
+   for(int m = 0; m < static_cast<int>(cells.size()); m++)
+      Place(m, cells[m]);
+}
+
+void MoveJournal::Rollback()
+{
+   for(int i = static_cast<int>(entries_.size()); i-- > 0;)
+   {
+      const Entry &e = entries_[i];
+      if( e.other >= 0 )
+      {
+         Place(e.other, e.to);
+      }
+      else
+      {
+         grid_->Set(e.to, 0);
+      }
+      Place(e.musician, e.from);
+   }
+   entries_.clear();
+}
+
+void MoveJournal::Replay(const std::vector<Entry> &entries)
+{
+   for(const Entry &e : entries)
+   {
+      if( e.other >= 0 )
+      {
+         Swap(e.musician, e.other);
+      }
+      else
+      {
+         Move(e.musician, e.to);
+      }
+   }
+}
@@ -0,0 +1,106 @@
+#ifndef MOVE_JOURNAL_H_
+#define MOVE_JOURNAL_H_
+
+#include<stdint.h>
+
+#include<vector>
+#include"grid.h"
+#include"intersect.h"
+
+// Apply musician movements to grid and placements, and keep a record of
+// what changed since the last commit.  This allows trial movements to be
+// undone without copying the full placement list.
+//
+// Musician positions are tracked as grid cells, with the matching XY
+// placements updated alongside for the scorers.  A Zobrist hash of the
+// cells is also maintained, so that repeated placements can be detected
+// without comparing cell lists.
+class MoveJournal
+{
+public:
+   struct Entry
+   {
+      int musician;
+      Cell from, to;
+
+      // If not -1, this entry is a swap, and this other musician moved
+      // from 'to' to 'from' at the same time.
+      int other = -1;
+   };
+
+   MoveJournal(Grid *grid,
+               std::vector<Cell> *cells,
+               std::vector<XY> *placements);
+
+   // Put a musician on a particular cell without recording the change
+   // or releasing the previous cell.  Used for populating an empty grid.
+   void Place(int m, const Cell &cell);
+
+   // Move a single musician to a particular cell.
+   void Move(int m, const Cell &cell);
+
+   // Swap cells of two musicians.
+   void Swap(int a, int b);
+
+   // Move a group of musicians to target cells, where targets may be
+   // cells currently held by other members of the group.  Targets must be
+   // distinct.  Members whose target is outside the grid or held by a
+   // musician that is not moving stay in place.  Returns number of
+   // musicians moved.
+   //
+   // This is recorded as a sequence of single moves, with members of a
+   // cycle going through a temporary free cell.
+   int MoveGroup(const std::vector<int> &musicians,
+                 const std::vector<Cell> &targets);
+
+   // Also keep single precision copies of placements in 'placements' for
+   // the float scorer, starting from current placements.  Null stops
+   // tracking.
+   void set_float_placements(std::vector<ScorePoint<float>> *placements);
+
+   // Move all musicians to the given cells without recording the
+   // changes.  Journal should be committed before calling this.
+   void Restore(const std::vector<Cell> &cells);
+
+   // Undo all movements since last commit, most recent first.
+   void Rollback();
+
+   // Accept all movements since last commit.
+   void Commit() { entries_.clear(); }
+
+   // Apply a list of movements that was previously recorded from the
+   // same starting state, e.g. a copy of entries() taken before Rollback().
+   void Replay(const std::vector<Entry> &entries);
+
+   // List of movements since last commit, in the order they were made.
+   // This is the diff between the committed state and current state.
+   const std::vector<Entry> &entries() const { return entries_; }
+
+   // Hash of current cells: XOR of a pseudo-random key for each
+   // (musician, cell) pair.  Equal cells reached through different
+   // movements have equal hashes.
+   uint64_t hash() const { return hash_; }
+
+   const std::vector<Cell> &cells() const { return *cells_; }
+   const std::vector<XY> &placements() const { return *placements_; }
+   const std::vector<ScorePoint<float>> &float_placements() const
+   {
+      return *float_placements_;
+   }
+   Grid *grid() { return grid_; }
+
+private:
+   // Zobrist key for musician 'm' on 'cell'.  Keys are derived from
+   // musician and cell indices rather than stored, so they are the same
+   // for all journals on the same grid.
+   uint64_t Key(int m, const Cell &cell) const;
+
+   Grid *grid_;
+   std::vector<Cell> *cells_;
+   std::vector<XY> *placements_;
+   std::vector<ScorePoint<float>> *float_placements_ = nullptr;
+   std::vector<Entry> entries_;
+   uint64_t hash_ = 0;
+};
+
+#endif  // MOVE_JOURNAL_H_
@@ -0,0 +1,265 @@
+#include"moves.h"
+
+#include<algorithm>
+#include<cstdlib>
+#include<functional>
+#include<vector>
+
+namespace {
+
+// Weight given to the latest reward in the running average.
+static constexpr double kRewardSmoothing = 0.05;
+
+// Minimum selection probability for each operator.
+static constexpr double kMinProbability = 0.04;
+
+// Cluster operator affects musicians within this many cells of the
+// center musician, in both directions.
+static constexpr int kClusterRadius = 2;
+
+// Number of attempts at finding two musicians of different instruments.
+static constexpr int kMaxSwapPicks = 8;
+
+static constexpr const char *kOperatorNames[MoveSet::kOperatorCount] =
+{
+   "relocate", "shift", "swap", "cluster", "slide", "instrument"
+};
+
+// Offsets to the 8 neighboring cells.
+static constexpr int kNeighbors[8][2] =
+{
+   {-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}
+};
+
+}  // namespace
+
+MoveSet::MoveSet(const Problem &problem, ProposalSampler *sampler)
+   : problem_(problem), sampler_(sampler)
+{
+   UpdateProbabilities();
+}
+
+int MoveSet::Propose(std::default_random_engine &rng, MoveJournal *journal)
+{
+   std::uniform_real_distribution<> unit(0.0, 1.0);
+   double r = unit(rng);
+   int op = kOperatorCount - 1;
+   for(int i = 0; i < kOperatorCount - 1; i++)
+   {
+      r -= stats_[i].probability;
+      if( r < 0 )
+      {
+         op = i;
+         break;
+      }
+   }
+
+   bool moved = false;
+   switch( op )
+   {
+      case kRelocate:   moved = Relocate(rng, journal); break;
+      case kShift:      moved = Shift(rng, journal); break;
+      case kSwap:       moved = Swap(rng, journal); break;
+      case kCluster:    moved = Cluster(rng, journal); break;
+      case kSlide:      moved = Slide(rng, journal); break;
+      case kInstrument: moved = Instrument(rng, journal); break;
+   }
+   stats_[op].proposals++;
+   if( !moved )
+   {
+      // Count no-ops as attempts with zero reward, so that operators
+      // that often fail to move are selected less.
+      stats_[op].no_ops++;
+      stats_[op].reward -= kRewardSmoothing * stats_[op].reward;
+      UpdateProbabilities();
+      return -1;
+   }
+   return op;
+}
+
+void MoveSet::Record(int op, double delta, bool accepted)
+{
+   OperatorStats &s = stats_[op];
+   s.reward += kRewardSmoothing * (std::max(0.0, delta) - s.reward);
+   if( accepted )
+      s.accepted++;
+   if( delta > 0 )
+      s.improved++;
+   UpdateProbabilities();
+}
+
+void MoveSet::PrintStats(FILE *output) const
+{
+   for(int i = 0; i < kOperatorCount; i++)
+   {
+      const OperatorStats &s = stats_[i];
+      fprintf(output, "Operator %s: %d proposals, %d no-ops, %d accepted, "
+              "%d improved, p = %.3f\n",
+              kOperatorNames[i], s.proposals, s.no_ops, s.accepted,
+              s.improved, s.probability);
+   }
+}
+
+bool MoveSet::Relocate(std::default_random_engine &rng, MoveJournal *journal)
+{
+   std::uniform_int_distribution<> musician_select(
+      0, static_cast<int>(problem_.musicians().size()) - 1);
+   const int m = musician_select(rng);
+
+   // All problems have spare room, so there is always a free cell.
+   journal->Move(m, sampler_ != nullptr
+                    ? sampler_->Sample(problem_.musicians()[m],
+                                       journal->grid(), rng)
+                    : journal->grid()->RandomFreeCell());
+   return true;
+}
+
+bool MoveSet::Shift(std::default_random_engine &rng, MoveJournal *journal)
+{
+   std::uniform_int_distribution<> musician_select(
+      0, static_cast<int>(problem_.musicians().size()) - 1);
+   std::uniform_int_distribution<> direction_select(0, 7);
+   const int m = musician_select(rng);
+   const int *d = kNeighbors[direction_select(rng)];
+
+   const Cell &from = journal->cells()[m];
+   const Cell to = Grid::MakeCell(from.column + d[0], from.row + d[1]);
+   const Grid *grid = journal->grid();
+   if( !grid->Contains(to) || grid->Get(to) != 0 )
+      return false;
+   journal->Move(m, to);
+   return true;
+}
+
+bool MoveSet::Swap(std::default_random_engine &rng, MoveJournal *journal)
+{
+   std::uniform_int_distribution<> musician_select(
+      0, static_cast<int>(problem_.musicians().size()) - 1);
+   const int a = musician_select(rng);
+   for(int i = 0; i < kMaxSwapPicks; i++)
+   {
+      const int b = musician_select(rng);
+      if( problem_.musicians()[a] != problem_.musicians()[b] )
+      {
+         journal->Swap(a, b);
+         return true;
+      }
+   }
+   return false;
+}
+
+bool MoveSet::Cluster(std::default_random_engine &rng, MoveJournal *journal)
+{
+   const int musician_count = static_cast<int>(problem_.musicians().size());
+   std::uniform_int_distribution<> musician_select(0, musician_count - 1);
+   const Cell center = journal->cells()[musician_select(rng)];
+
+   // Transforms are mirror along either axis, or rotation by 90, 180, or
+   // 270 degrees.  All of these map distinct cells to distinct cells.
+   std::uniform_int_distribution<> transform_select(0, 4);
+   const int transform = transform_select(rng);
+
+   std::vector<int> group;
+   std::vector<Cell> targets;
+   for(int m = 0; m < musician_count; m++)
+   {
+      const Cell &c = journal->cells()[m];
+      const int dx = c.column - center.column;
+      const int dy = c.row - center.row;
+      if( std::abs(dx) > kClusterRadius || std::abs(dy) > kClusterRadius )
+         continue;
+
+      int tx = dx, ty = dy;
+      switch( transform )
+      {
+         case 0: tx = -dx; break;
+         case 1: ty = -dy; break;
+         case 2: tx = -dy; ty = dx; break;
+         case 3: tx = -dx; ty = -dy; break;
+         case 4: tx = dy; ty = -dx; break;
+      }
+      group.push_back(m);
+      targets.push_back(
+         Grid::MakeCell(center.column + tx, center.row + ty));
+   }
+   return journal->MoveGroup(group, targets) > 0;
+}
+
+bool MoveSet::Slide(std::default_random_engine &rng, MoveJournal *journal)
+{
+   const int musician_count = static_cast<int>(problem_.musicians().size());
+   std::uniform_int_distribution<> musician_select(0, musician_count - 1);
+   std::bernoulli_distribution coin(0.5);
+   const Cell origin = journal->cells()[musician_select(rng)];
+   const bool horizontal = coin(rng);
+
+   // Slide toward whichever edge is nearer along the selected axis.
+   const Grid *grid = journal->grid();
+   const int position = horizontal ? origin.column : origin.row;
+   const int extent = horizontal ? grid->columns() : grid->rows();
+   const int step = position * 2 < extent ? -1 : 1;
+
+   // Collect musicians on the same line, nearest to the edge first so
+   // that each one moves into space vacated by the previous one.
+   std::vector<std::pair<int, int>> line;
+   for(int m = 0; m < musician_count; m++)
+   {
+      const Cell &c = journal->cells()[m];
+      if( horizontal ? c.row == origin.row : c.column == origin.column )
+         line.emplace_back((horizontal ? c.column : c.row) * step, m);
+   }
+   std::sort(line.begin(), line.end(), std::greater<std::pair<int, int>>());
+
+   bool moved = false;
+   for(const auto &entry : line)
+   {
+      const int m = entry.second;
+      const Cell &from = journal->cells()[m];
+      const Cell to = horizontal
+         ? Grid::MakeCell(from.column + step, from.row)
+         : Grid::MakeCell(from.column, from.row + step);
+      if( grid->Contains(to) && grid->Get(to) == 0 )
+      {
+         journal->Move(m, to);
+         moved = true;
+      }
+   }
+   return moved;
+}
+
+bool MoveSet::Instrument(std::default_random_engine &rng,
+                         MoveJournal *journal)
+{
+   const int musician_count = static_cast<int>(problem_.musicians().size());
+   std::uniform_int_distribution<> musician_select(0, musician_count - 1);
+   std::uniform_int_distribution<> direction_select(0, 7);
+   const int instrument = problem_.musicians()[musician_select(rng)];
+   const int *d = kNeighbors[direction_select(rng)];
+
+   std::vector<int> group;
+   std::vector<Cell> targets;
+   for(int m = 0; m < musician_count; m++)
+   {
+      if( problem_.musicians()[m] != instrument )
+         continue;
+      const Cell &c = journal->cells()[m];
+      group.push_back(m);
+      targets.push_back(Grid::MakeCell(c.column + d[0], c.row + d[1]));
+   }
+   return journal->MoveGroup(group, targets) > 0;
+}
+
+void MoveSet::UpdateProbabilities()
+{
+   double total = 0;
+   for(const OperatorStats &s : stats_)
+      total += s.reward;
+
+   for(OperatorStats &s : stats_)
+   {
+      s.probability = total > 0
+         ? kMinProbability +
+           (1 - kOperatorCount * kMinProbability) * s.reward / total
+         : 1.0 / kOperatorCount;
+   }
+}
@@ -0,0 +1,86 @@
+#ifndef MOVES_H_
+#define MOVES_H_
+
+#include<stdio.h>
+
+#include<array>
+#include<random>
+#include"move_journal.h"
+#include"problem.h"
+#include"proposal.h"
+
+// Library of move operators, with adaptive operator selection.
+//
+// Each operator applies a small change through a MoveJournal.  Operators
+// are selected by probability matching: each operator keeps a running
+// average of score gain per attempt (worsening moves and no-ops count as
+// zero), and is selected in proportion to that average, with a floor so
+// that no operator is starved.
+class MoveSet
+{
+public:
+   enum Operator
+   {
+      // Move one musician to a free cell anywhere on stage.
+      kRelocate,
+
+      // Move one musician to a free neighboring cell.
+      kShift,
+
+      // Swap two musicians of different instruments.
+      kSwap,
+
+      // Rotate or mirror musicians near a random musician.
+      kCluster,
+
+      // Slide musicians in one row or column toward the nearest stage edge.
+      kSlide,
+
+      // Shift all musicians of one instrument by one cell.
+      kInstrument,
+
+      kOperatorCount
+   };
+
+   // If 'sampler' is not null, relocations draw destinations from it.
+   MoveSet(const Problem &problem, ProposalSampler *sampler);
+
+   // Select an operator and apply it through journal.  Returns the
+   // operator that was applied, or -1 if the selected operator could not
+   // make any movement, in which case a zero reward is recorded for it.
+   int Propose(std::default_random_engine &rng, MoveJournal *journal);
+
+   // Record score change and acceptance for the last proposal.
+   void Record(int op, double delta, bool accepted);
+
+   // Write per-operator statistics.
+   void PrintStats(FILE *output) const;
+
+private:
+   // Individual operators.  Each returns false if no movement was made.
+   bool Relocate(std::default_random_engine &rng, MoveJournal *journal);
+   bool Shift(std::default_random_engine &rng, MoveJournal *journal);
+   bool Swap(std::default_random_engine &rng, MoveJournal *journal);
+   bool Cluster(std::default_random_engine &rng, MoveJournal *journal);
+   bool Slide(std::default_random_engine &rng, MoveJournal *journal);
+   bool Instrument(std::default_random_engine &rng, MoveJournal *journal);
+
+   // Update selection probabilities from rewards.
+   void UpdateProbabilities();
+
+   struct OperatorStats
+   {
+      double reward = 0;
+      double probability = 0;
+      int proposals = 0;
+      int no_ops = 0;
+      int accepted = 0;
+      int improved = 0;
+   };
+
+   const Problem &problem_;
+   ProposalSampler *sampler_;
+   std::array<OperatorStats, kOperatorCount> stats_;
+};
+
+#endif  // MOVES_H_
@@ -0,0 +1,46 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include<algorithm>
+#include<thread>
+#include<vector>
+
+// Number of worker threads to use for parallel loops.
+inline int ThreadCount()
+{
+   return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// Call function(i) for all i in [0, count), split across threads in
+// contiguous blocks.  function must be safe to call concurrently for
+// different values of i.
+template<typename Function>
+void ParallelFor(int count, const Function &function)
+{
+   const int thread_count = std::min(ThreadCount(), count);
+   if( thread_count <= 1 )
+   {
+      for(int i = 0; i < count; i++)
+         function(i);
+      return;
+   }
+
+   std::vector<std::thread> threads;
+   threads.reserve(thread_count);
+   for(int t = 0; t < thread_count; t++)
+   {
+      const int begin = static_cast<int>(
+         static_cast<long long>(count) * t / thread_count);
+      const int end = static_cast<int>(
+         static_cast<long long>(count) * (t + 1) / thread_count);
+      threads.emplace_back([begin, end, &function]()
+      {
+         for(int i = begin; i < end; i++)
+            function(i);
+      });
+   }
+   for(std::thread &t : threads)
+      t.join();
+}
+
+#endif  // PARALLEL_H_
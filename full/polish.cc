@@ -0,0 +1,220 @@
+#include"polish.h"
+
+#include<algorithm>
+#include<cmath>
+#include<vector>
+
+#include"delta_score.h"
+#include"grid.h"
+
+namespace {
+
+// Minimum distance between musicians and from musicians to stage edges.
+static constexpr double kSpacing = 10;
+
+// Extra distance kept from constraint boundaries, so that positions
+// still satisfy constraints after being written with limited precision.
+static constexpr double kSlack = 1e-3;
+
+// Step length bounds.  Steps start at a fraction of a cell, grow on
+// success, and shrink on failure.  Musicians whose step falls below the
+// minimum are considered converged.
+static constexpr double kInitialStep = Grid::kCellSize / 4;
+static constexpr double kMaxStep = Grid::kCellSize / 2;
+static constexpr double kMinStep = 1e-2;
+
+// Number of attempts to push a step out of other musicians' spacing.
+static constexpr int kProjectionIterations = 4;
+
+// Stop when a pass gains less than this fraction of the score.
+static constexpr double kMinRelativeGain = 1e-6;
+
+// Sum of unscaled scores over visible attendees for each musician.
+static void ComputeVisibleBase(const DeltaScorer &scorer,
+                               std::vector<double> *sums)
+{
+   for(int m = 0; m < scorer.musician_count(); m++)
+   {
+      double sum = 0;
+      for(int j = 0; j < scorer.attendee_count(); j++)
+      {
+         if( scorer.Visible(m, j) )
+            sum += scorer.base(m, j);
+      }
+      (*sums)[m] = sum;
+   }
+}
+
+// Gradient of score with respect to position of musician 'm'.
+static XY Gradient(const Problem &problem,
+                   const DeltaScorer &scorer,
+                   const std::vector<double> &visible_base,
+                   int m)
+{
+   const XY &p = scorer.position(m);
+   const int instrument = problem.musicians()[m];
+
+   // d/dp (1e6 * t / |a-p|^2) = 2e6 * t * (a-p) / |a-p|^4
+   XY g{0, 0};
+   for(int j = 0; j < scorer.attendee_count(); j++)
+   {
+      if( !scorer.Visible(m, j) )
+         continue;
+      const Problem::Attendee &a = problem.attendees()[j];
+      const double dx = a.position.x - p.x;
+      const double dy = a.position.y - p.y;
+      const double d2 = dx * dx + dy * dy;
+      const double w = 2e6 * a.tastes[instrument] / (d2 * d2);
+      g.x += w * dx;
+      g.y += w * dy;
+   }
+   const double scale = scorer.volume(m) * scorer.closeness(m);
+   g.x *= scale;
+   g.y *= scale;
+
+   // Closeness factor of both m and k includes 1/|p_m-p_k|, so moving m
+   // changes both contributions:
+   //   d/dp_m (1/|p_m-p_k|) = -(p_m-p_k) / |p_m-p_k|^3
+   if( problem.UseClosenessExtension() )
+   {
+      const double own = scorer.volume(m) * visible_base[m];
+      for(int k = 0; k < scorer.musician_count(); k++)
+      {
+         if( k == m || problem.musicians()[k] != instrument )
+            continue;
+         const XY &q = scorer.position(k);
+         const double dx = p.x - q.x;
+         const double dy = p.y - q.y;
+         const double d = std::hypot(dx, dy);
+         const double w =
+            -(own + scorer.volume(k) * visible_base[k]) / (d * d * d);
+         g.x += w * dx;
+         g.y += w * dy;
+      }
+   }
+   return g;
+}
+
+// Project 'p' onto stage and spacing constraints for musician 'm'.
+// Returns false if no feasible position was found near 'p'.
+static bool Project(const DeltaScorer &scorer,
+                    const XY &stage_min,
+                    const XY &stage_max,
+                    int m,
+                    XY *p)
+{
+   static constexpr double kMinDistance = kSpacing + kSlack;
+   for(int i = 0; i <= kProjectionIterations; i++)
+   {
+      p->x = std::min(std::max(p->x, stage_min.x), stage_max.x);
+      p->y = std::min(std::max(p->y, stage_min.y), stage_max.y);
+
+      int nearest = -1;
+      double nearest_d2 = kMinDistance * kMinDistance;
+      for(int k = 0; k < scorer.musician_count(); k++)
+      {
+         if( k == m )
+            continue;
+         const XY &q = scorer.position(k);
+         const double d2 = (p->x - q.x) * (p->x - q.x) +
+                           (p->y - q.y) * (p->y - q.y);
+         if( d2 < nearest_d2 )
+         {
+            nearest = k;
+            nearest_d2 = d2;
+         }
+      }
+      if( nearest < 0 )
+         return true;
+      if( nearest_d2 == 0 || i == kProjectionIterations )
+         return false;
+
+      // Push out radially from the nearest musician.
+      const XY &q = scorer.position(nearest);
+      const double scale = kMinDistance / std::sqrt(nearest_d2);
+      p->x = q.x + (p->x - q.x) * scale;
+      p->y = q.y + (p->y - q.y) * scale;
+   }
+   return false;
+}
+
+}  // namespace
+
+int Polish(const Problem &problem,
+           int attendee_count,
+           std::chrono::steady_clock::duration duration,
+           Solution *solution)
+{
+   const auto end_time = std::chrono::steady_clock::now() + duration;
+   const int musician_count = static_cast<int>(problem.musicians().size());
+   DeltaScorer scorer(problem, solution->placements, solution->volumes,
+                      attendee_count);
+
+   const double margin = kSpacing + kSlack;
+   const XY stage_min =
+   {
+      problem.stage_bottom_left().x + margin,
+      problem.stage_bottom_left().y + margin
+   };
+   const XY stage_max =
+   {
+      problem.stage_bottom_left().x + problem.stage_size().x - margin,
+      problem.stage_bottom_left().y + problem.stage_size().y - margin
+   };
+
+   std::vector<double> step(musician_count, kInitialStep);
+   std::vector<double> visible_base(musician_count);
+   int kept = 0;
+   bool active = true;
+   while( active && std::chrono::steady_clock::now() < end_time )
+   {
+      const double pass_score = scorer.score();
+      ComputeVisibleBase(scorer, &visible_base);
+      active = false;
+      for(int m = 0; m < musician_count; m++)
+      {
+         if( step[m] < kMinStep )
+            continue;
+         if( std::chrono::steady_clock::now() >= end_time )
+            break;
+
+         const XY g = Gradient(problem, scorer, visible_base, m);
+         const double norm = std::hypot(g.x, g.y);
+         if( norm == 0 )
+            continue;
+         active = true;
+
+         const XY old_position = scorer.position(m);
+         XY p{old_position.x + g.x / norm * step[m],
+              old_position.y + g.y / norm * step[m]};
+         if( !Project(scorer, stage_min, stage_max, m, &p) ||
+             (p.x == old_position.x && p.y == old_position.y) )
+         {
+            step[m] /= 2;
+            continue;
+         }
+
+         const double old_score = scorer.score();
+         scorer.Move(m, p);
+         if( scorer.score() > old_score )
+         {
+            step[m] = std::min(step[m] * 2, kMaxStep);
+            kept++;
+         }
+         else
+         {
+            scorer.Move(m, old_position);
+            step[m] /= 2;
+         }
+      }
+      // Passes without gain are not counted as converged, since they
+      // shrink step lengths for the next pass.
+      const double gain = scorer.score() - pass_score;
+      if( gain > 0 && gain < kMinRelativeGain * std::fabs(pass_score) )
+         break;
+   }
+
+   for(int m = 0; m < musician_count; m++)
+      solution->placements[m] = scorer.position(m);
+   return kept;
+}
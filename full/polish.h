@@ -0,0 +1,26 @@
+#ifndef POLISH_H_
+#define POLISH_H_
+
+#include<chrono>
+#include"problem.h"
+#include"solution.h"
+
+// Refine placements in continuous space after grid search.
+//
+// Each musician in turn takes a step along the analytic gradient of its
+// 1/d^2 terms and the closeness terms it shares with musicians of the
+// same instrument.  Steps are projected back onto stage margin and
+// spacing constraints, then rescored exactly with DeltaScorer over the
+// first 'attendee_count' attendees, so that visibility changes caused by
+// the step are accounted for.  Improving steps are kept and grow the
+// musician's step length, others are undone and shrink it.
+//
+// Polishing stops when a full pass over all musicians gains some but less
+// than a small fraction of the score, when all step lengths fall below a
+// minimum, or after 'duration'.  Returns number of steps kept.
+int Polish(const Problem &problem,
+           int attendee_count,
+           std::chrono::steady_clock::duration duration,
+           Solution *solution);
+
+#endif  // POLISH_H_
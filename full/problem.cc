@@ -6,6 +6,7 @@
 #include<limits>
 #include<vector>
 
+#include"hilbert.h"
 #include"json_util.h"
 
 #ifdef BENCHMARK
@@ -156,6 +157,11 @@ Problem::Problem(const std::string &json_text)
       }
    };
    std::sort(attendees_.begin(), attendees_.end(), SortByInfluenceRange());
+   influence_rank_.resize(attendees_.size());
+   for(int i = 0; i < static_cast<int>(attendees_.size()); i++)
+      influence_rank_[i] = i;
+
+   BuildScoreTables();
 
    #ifdef BENCHMARK
       const std::chrono::duration<double> elapsed =
@@ -164,6 +170,51 @@ Problem::Problem(const std::string &json_text)
    #endif
 }
 
+void Problem::UseSpatialOrder(int sample_size)
+{
+   // Restore influence order first, so that the sample boundary is
+   // well defined even if this function is called more than once.
+   std::vector<Attendee> sorted(attendees_.size());
+   for(int i = 0; i < static_cast<int>(attendees_.size()); i++)
+      sorted[influence_rank_[i]] = attendees_[i];
+
+   std::vector<std::pair<uint32_t, int>> keys;
+   keys.reserve(sorted.size());
+   for(int i = 0; i < static_cast<int>(sorted.size()); i++)
+   {
+      keys.push_back(std::make_pair(
+         HilbertIndex(sorted[i].position.x, sorted[i].position.y,
+                      room_size_.x, room_size_.y),
+         i));
+   }
+   const int boundary =
+      std::clamp(sample_size, 0, static_cast<int>(keys.size()));
+   std::sort(keys.begin(), keys.begin() + boundary);
+   std::sort(keys.begin() + boundary, keys.end());
+
+   for(int i = 0; i < static_cast<int>(keys.size()); i++)
+   {
+      attendees_[i] = sorted[keys[i].second];
+      influence_rank_[i] = keys[i].second;
+   }
+   spatial_order_ = true;
+   BuildScoreTables();
+}
+
+void Problem::BuildScoreTables()
+{
+   const int instrument_count = static_cast<int>(instruments_.size());
+   score_tables_ = ScoreTables<double>();
+   float_score_tables_ = ScoreTables<float>();
+   score_tables_.SetAttendees(attendees_, instrument_count);
+   float_score_tables_.SetAttendees(attendees_, instrument_count);
+   for(const Pillar &p : pillars_)
+   {
+      score_tables_.AddPillar(p.position.x, p.position.y, p.radius);
+      float_score_tables_.AddPillar(p.position.x, p.position.y, p.radius);
+   }
+}
+
 void Problem::ComputeInfluences()
 {
    static constexpr double kMargin = 10;
@@ -5,6 +5,7 @@
 #include<vector>
 
 #include"intersect.h"
+#include"score_core.h"
 
 class Problem
 {
@@ -27,6 +28,12 @@ public:
 
    explicit Problem(const std::string &json_text);
 
+   // Reorder attendees along a Hilbert curve for better locality in the
+   // scoring loops.  The 'sample_size' most influential attendees are
+   // kept in front of the rest, so that scores computed with the first
+   // 'sample_size' attendees still use the same sample.
+   void UseSpatialOrder(int sample_size);
+
    // Check if any pillar blocks the line between 'u' and 'v'.
    bool BlockedByPillar(const XY &u, const XY &v) const;
 
@@ -41,12 +48,22 @@ public:
    const std::vector<int> &instruments() const { return instruments_; }
    const std::vector<int> &musicians() const { return musicians_; }
    const std::vector<Attendee> &attendees() const { return attendees_; }
+   const std::vector<int> &influence_rank() const { return influence_rank_; }
+   bool spatial_order() const { return spatial_order_; }
    const std::vector<Pillar> &pillars() const { return pillars_; }
+   const ScoreTables<double> &score_tables() const { return score_tables_; }
+   const ScoreTables<float> &float_score_tables() const
+   {
+      return float_score_tables_;
+   }
 
 private:
    // Compute maximum influence for each attendee.
    void ComputeInfluences();
 
+   // Copy attendees and pillars to score tables.
+   void BuildScoreTables();
+
    // Room and stage dimensions.
    XY room_size_;
    XY stage_size_;
@@ -59,11 +76,23 @@ private:
    std::vector<int> instruments_;
 
    // Attendee preferences, sorted by attendees who are most sensitive to
-   // placement changes first.
+   // placement changes first, unless spatial order is used.
    std::vector<Attendee> attendees_;
 
+   // Rank of each attendee by sensitivity to placement changes, such
+   // that attendees_[i] is the (influence_rank_[i]+1)-th most sensitive.
+   // This is the identity mapping unless spatial order is used.
+   std::vector<int> influence_rank_;
+
+   // True if attendees are sorted along a Hilbert curve.
+   bool spatial_order_ = false;
+
    // Pillar positions.
    std::vector<Pillar> pillars_;
+
+   // Copy of attendees and pillars for the scoring core.
+   ScoreTables<double> score_tables_;
+   ScoreTables<float> float_score_tables_;
 };
 
 #endif  // PROBLEM_H_
@@ -0,0 +1,133 @@
+#include"proposal.h"
+
+#include<algorithm>
+#include<limits>
+
+namespace {
+
+// Number of rejected draws before falling back to uniform sampling.
+static constexpr int kMaxRejectedDraws = 16;
+
+// Minimum number of draws before checking if table should be rebuilt.
+static constexpr int kRebuildWindow = 64;
+
+// Rebuild table if more than this fraction of recent draws were rejected.
+static constexpr double kRebuildMissRate = 0.5;
+
+// Rebuild tables with excluded cells after this many draws.
+static constexpr int kMaxExcludedAge = 4096;
+
+// Weight floor relative to value range, so that cells with the lowest
+// values are still proposed occasionally.
+static constexpr double kWeightFloor = 0.05;
+
+}  // namespace
+
+ProposalSampler::ProposalSampler(const CellValues &values, const Grid &grid)
+   : values_(values),
+     cell_count_(grid.rows() * grid.columns()),
+     tables_(values.instrument_count())
+{
+   for(int i = 0; i < values.instrument_count(); i++)
+      Build(i, grid, false);
+}
+
+Cell ProposalSampler::Sample(int instrument,
+                             Grid *grid,
+                             std::default_random_engine &rng)
+{
+   AliasTable &table = tables_[instrument];
+   if( table.excluded_age >= kMaxExcludedAge )
+   {
+      Build(instrument, *grid, true);
+      table.draws = table.misses = 0;
+   }
+   if( table.draws >= kRebuildWindow )
+   {
+      if( table.misses > table.draws * kRebuildMissRate )
+         Build(instrument, *grid, true);
+      table.draws = table.misses = 0;
+   }
+   if( table.excluded_age >= 0 )
+      table.excluded_age++;
+
+   std::uniform_int_distribution<int> select_cell(0, cell_count_ - 1);
+   std::uniform_real_distribution<float> select_side(0, 1);
+   for(int i = 0; i < kMaxRejectedDraws; i++)
+   {
+      int index = select_cell(rng);
+      if( select_side(rng) >= table.probability[index] )
+         index = table.alias[index];
+
+      table.draws++;
+      const Cell cell = grid->FromIndex(index);
+      if( grid->Get(cell) == 0 )
+         return cell;
+      table.misses++;
+      rejections_++;
+   }
+   return grid->RandomFreeCell();
+}
+
+void ProposalSampler::Build(int instrument,
+                            const Grid &grid,
+                            bool exclude_occupied)
+{
+   // Compute weights from values, shifted to be positive.
+   std::vector<double> weight(cell_count_);
+   double min_value = std::numeric_limits<double>::infinity();
+   double max_value = -min_value;
+   for(int i = 0; i < cell_count_; i++)
+   {
+      weight[i] = values_.PillarAwareValue(grid.FromIndex(i), instrument);
+      min_value = std::min(min_value, weight[i]);
+      max_value = std::max(max_value, weight[i]);
+   }
+   const double floor = (max_value - min_value) * kWeightFloor + 1e-9;
+   double total = 0;
+   for(int i = 0; i < cell_count_; i++)
+   {
+      if( exclude_occupied && grid.Get(grid.FromIndex(i)) != 0 )
+         weight[i] = floor;
+      else
+         weight[i] = weight[i] - min_value + floor;
+      total += weight[i];
+   }
+
+   // Build alias table with Vose's method.
+   AliasTable &table = tables_[instrument];
+   table.excluded_age = exclude_occupied ? 0 : -1;
+   table.probability.assign(cell_count_, 1);
+   table.alias.resize(cell_count_);
+   for(int i = 0; i < cell_count_; i++)
+      table.alias[i] = i;
+   if( total <= 0 )
+      return;
+
+   std::vector<int> small, large;
+   std::vector<double> scaled(cell_count_);
+   for(int i = 0; i < cell_count_; i++)
+   {
+      scaled[i] = weight[i] * cell_count_ / total;
+      (scaled[i] < 1 ? small : large).push_back(i);
+   }
+   while( !small.empty() && !large.empty() )
+   {
+      const int s = small.back();
+      small.pop_back();
+      const int l = large.back();
+      table.probability[s] = static_cast<float>(scaled[s]);
+      table.alias[s] = l;
+      scaled[l] -= 1 - scaled[s];
+      if( scaled[l] < 1 )
+      {
+         large.pop_back();
+         small.push_back(l);
+      }
+   }
+   // Remaining entries are 1 up to rounding errors.
+   for(int i : small)
+      table.probability[i] = 1;
+   for(int i : large)
+      table.probability[i] = 1;
+}
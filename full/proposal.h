@@ -0,0 +1,56 @@
+#ifndef PROPOSAL_H_
+#define PROPOSAL_H_
+
+#include<random>
+#include<vector>
+#include"cell_values.h"
+#include"grid.h"
+
+// Select free cells for musicians with probability proportional to
+// precomputed cell values for their instrument, using one Walker alias
+// table per instrument.
+//
+// Tables are built over all cells, and draws that land on occupied cells
+// are rejected and redrawn.  When an instrument sees too many rejections
+// (because its preferred cells are filled), its table is rebuilt with the
+// currently occupied cells down-weighted to the floor weight.  Those
+// cells may be vacated later, so such tables are also rebuilt after a
+// fixed number of draws, so that stale exclusions expire.
+class ProposalSampler
+{
+public:
+   ProposalSampler(const CellValues &values, const Grid &grid);
+
+   // Draw a free cell for an instrument.  Falls back to a uniformly
+   // random free cell if too many draws were rejected.
+   Cell Sample(int instrument, Grid *grid, std::default_random_engine &rng);
+
+   // Number of draws that landed on occupied cells.
+   int rejections() const { return rejections_; }
+
+private:
+   struct AliasTable
+   {
+      std::vector<float> probability;
+      std::vector<int> alias;
+
+      // Recent draw statistics, for deciding when to rebuild.
+      int draws = 0;
+      int misses = 0;
+
+      // Number of draws since the table was built with occupied cells
+      // excluded, or -1 if it was built without exclusions.
+      int excluded_age = -1;
+   };
+
+   // Build table for a single instrument, optionally giving cells that
+   // are currently occupied the floor weight.
+   void Build(int instrument, const Grid &grid, bool exclude_occupied);
+
+   const CellValues &values_;
+   int cell_count_;
+   std::vector<AliasTable> tables_;
+   int rejections_ = 0;
+};
+
+#endif  // PROPOSAL_H_
@@ -0,0 +1,248 @@
+#include"relocate.h"
+
+#include<stdio.h>
+
+#include<algorithm>
+#include<atomic>
+#include<cmath>
+#include<functional>
+#include<thread>
+#include<utility>
+#include<vector>
+
+#include"cell_values.h"
+#include"delta_score.h"
+#include"grid.h"
+#include"parallel.h"
+
+namespace {
+
+// Minimum distance between musicians.
+static constexpr double kSpacing = 10;
+
+// Number of available cells per musician that are scored exactly.  Each
+// exact evaluation costs O(M*A), so all available cells are first ranked
+// by cell value, which ignores musicians.
+static constexpr int kScreenedCells = 32;
+
+// Number of cells per musician that are scored exactly after ranking all
+// cells with DeltaScorer::MoveValues.  That ranking is exact except for
+// rounding of closeness changes, so only a few cells need to be checked.
+static constexpr int kVerifiedCells = 4;
+
+// Best relocation found for a single musician.
+struct Candidate
+{
+   double gain;
+   int musician;
+   int cell;
+};
+
+// Number of musicians within spacing distance of each grid cell.
+// Musicians may be off grid, so each one can make up to 3x3 cells
+// unavailable.
+class Occupancy
+{
+public:
+   explicit Occupancy(const Grid &grid)
+      : grid_(grid), count_(grid.rows() * grid.columns(), 0)
+   {
+   }
+
+   // Add or remove a musician at 'p'.
+   void Mark(const XY &p, int delta)
+   {
+      const XY origin = grid_.ToXY(0, 0);
+      const int column_begin = std::max(0, static_cast<int>(
+         std::ceil((p.x - kSpacing - origin.x) / Grid::kCellSize)));
+      const int column_end = std::min(grid_.columns() - 1, static_cast<int>(
+         std::floor((p.x + kSpacing - origin.x) / Grid::kCellSize)));
+      const int row_begin = std::max(0, static_cast<int>(
+         std::ceil((p.y - kSpacing - origin.y) / Grid::kCellSize)));
+      const int row_end = std::min(grid_.rows() - 1, static_cast<int>(
+         std::floor((p.y + kSpacing - origin.y) / Grid::kCellSize)));
+      for(int row = row_begin; row <= row_end; row++)
+      {
+         for(int column = column_begin; column <= column_end; column++)
+         {
+            if( TooClose(p, grid_.ToXY(column, row)) )
+               count_[row * grid_.columns() + column] += delta;
+         }
+      }
+   }
+
+   // Check if cell is available to a musician currently at 'p'.
+   bool Available(int cell, const XY &p) const
+   {
+      const int self = TooClose(p, grid_.ToXY(grid_.FromIndex(cell))) ? 1 : 0;
+      return count_[cell] == self;
+   }
+
+   int size() const { return static_cast<int>(count_.size()); }
+
+private:
+   static bool TooClose(const XY &a, const XY &b)
+   {
+      const double dx = a.x - b.x;
+      const double dy = a.y - b.y;
+      return dx * dx + dy * dy < kSpacing * kSpacing;
+   }
+
+   const Grid &grid_;
+   std::vector<int> count_;
+};
+
+// Find the best relocation for each musician, splitting musicians across
+// threads.  Each thread evaluates moves on its own copy of 'scorer'.
+//
+// Cells are ranked by cell value, unless 'exhaustive' is set, in which
+// case they are ranked by move values computed for all cells at once.
+// The latter is more accurate but costs about as much as exact scoring
+// of C/M cells.
+static std::vector<Candidate> FindCandidates(
+   const Problem &problem,
+   const Grid &grid,
+   const CellValues &values,
+   const Occupancy &occupancy,
+   const DeltaScorer &scorer,
+   bool exhaustive,
+   std::chrono::steady_clock::time_point end_time)
+{
+   const int musician_count = scorer.musician_count();
+   std::vector<Candidate> candidates(musician_count);
+   for(int m = 0; m < musician_count; m++)
+      candidates[m] = Candidate{0, m, -1};
+
+   std::atomic<int> next_musician(0);
+   const int thread_count = std::min(ThreadCount(), musician_count);
+   std::vector<std::thread> threads;
+   threads.reserve(thread_count);
+   for(int t = 0; t < thread_count; t++)
+   {
+      threads.emplace_back([&]()
+      {
+         DeltaScorer local(scorer);
+         std::vector<double> move_values;
+         std::vector<std::pair<double, int>> ranked;
+         for(int m = next_musician++;
+             m < musician_count && std::chrono::steady_clock::now() < end_time;
+             m = next_musician++)
+         {
+            const XY p = local.position(m);
+            const int instrument = problem.musicians()[m];
+            if( exhaustive )
+               local.MoveValues(m, grid, &move_values);
+            ranked.clear();
+            for(int cell = 0; cell < occupancy.size(); cell++)
+            {
+               if( !occupancy.Available(cell, p) )
+                  continue;
+               ranked.emplace_back(
+                  exhaustive
+                     ? move_values[cell]
+                     : values.PillarAwareValue(grid.FromIndex(cell),
+                                               instrument),
+                  cell);
+            }
+            const int screened =
+               std::min(exhaustive ? kVerifiedCells : kScreenedCells,
+                        static_cast<int>(ranked.size()));
+            std::partial_sort(ranked.begin(), ranked.begin() + screened,
+                              ranked.end(),
+                              std::greater<std::pair<double, int>>());
+
+            const double base_score = local.score();
+            Candidate &best = candidates[m];
+            for(int i = 0; i < screened; i++)
+            {
+               const int cell = ranked[i].second;
+               local.Move(m, grid.ToXY(grid.FromIndex(cell)));
+               const double gain = local.score() - base_score;
+               local.Move(m, p);
+               if( gain > best.gain )
+               {
+                  best.gain = gain;
+                  best.cell = cell;
+               }
+            }
+         }
+      });
+   }
+   for(std::thread &t : threads)
+      t.join();
+   return candidates;
+}
+
+}  // namespace
+
+int RelocateToLocalOptimum(const Problem &problem,
+                           std::chrono::steady_clock::duration duration,
+                           Solution *solution)
+{
+   const auto end_time = std::chrono::steady_clock::now() + duration;
+   const int musician_count = static_cast<int>(problem.musicians().size());
+   const Grid grid(problem);
+   DeltaScorer scorer(problem, solution->placements, solution->volumes,
+                      static_cast<int>(problem.attendees().size()));
+   const CellValues values(problem, grid);
+   Occupancy occupancy(grid);
+   for(int m = 0; m < musician_count; m++)
+      occupancy.Mark(scorer.position(m), 1);
+
+   // Start with cheap rounds ranked by cell value, and switch to
+   // exhaustive rounds once those stop finding improvements.
+   int relocations = 0;
+   bool exhaustive = false;
+   for(int round = 0; std::chrono::steady_clock::now() < end_time; round++)
+   {
+      std::vector<Candidate> candidates =
+         FindCandidates(problem, grid, values, occupancy, scorer, exhaustive,
+                        end_time);
+      candidates.erase(
+         std::remove_if(candidates.begin(), candidates.end(),
+                        [](const Candidate &c) { return c.cell < 0; }),
+         candidates.end());
+      std::sort(candidates.begin(), candidates.end(),
+                [](const Candidate &a, const Candidate &b)
+                {
+                   return a.gain > b.gain;
+                });
+
+      // Apply moves in order of decreasing gain.  Gains were computed
+      // against placements at the start of the round, so each move is
+      // rescored and undone if earlier moves made it worthless.
+      int applied = 0;
+      for(const Candidate &c : candidates)
+      {
+         const XY old_position = scorer.position(c.musician);
+         if( !occupancy.Available(c.cell, old_position) )
+            continue;
+         const double old_score = scorer.score();
+         const XY new_position = grid.ToXY(grid.FromIndex(c.cell));
+         scorer.Move(c.musician, new_position);
+         if( scorer.score() <= old_score )
+         {
+            scorer.Move(c.musician, old_position);
+            continue;
+         }
+         occupancy.Mark(old_position, -1);
+         occupancy.Mark(new_position, 1);
+         applied++;
+      }
+      fprintf(stderr, "Relocation round %d%s: applied %d of %d candidates, "
+              "score = %.0f\n",
+              round, exhaustive ? " (exhaustive)" : "", applied,
+              static_cast<int>(candidates.size()), scorer.score());
+      relocations += applied;
+      if( applied == 0 )
+      {
+         if( exhaustive )
+            break;
+         exhaustive = true;
+      }
+   }
+
+   for(int m = 0; m < musician_count; m++)
+      solution->placements[m] = scorer.position(m);
+   return relocations;
+}
@@ -0,0 +1,28 @@
+#ifndef RELOCATE_H_
+#define RELOCATE_H_
+
+#include<chrono>
+#include"problem.h"
+#include"solution.h"
+
+// Move musicians of a finished solution to a local optimum with respect
+// to single relocations.
+//
+// Each round ranks every grid cell that keeps spacing from all other
+// musicians, and evaluates relocating each musician to its best ranked
+// cells with DeltaScorer over all attendees.  Cells are first ranked by
+// cell value, which is cheap but ignores musicians.  Once that stops
+// finding improvements, cells are ranked by DeltaScorer::MoveValues,
+// which accounts for blocking and closeness.  Evaluation is split across
+// threads, each with its own copy of the scorer.  Best improving moves
+// are then applied in order of decreasing gain, each rescored against
+// moves already applied in the same round, so that conflicting moves are
+// dropped.  Rounds repeat until no move improves or 'duration' runs out.
+//
+// Placements do not need to be on grid, only relocation targets are.
+// Returns number of relocations applied.
+int RelocateToLocalOptimum(const Problem &problem,
+                           std::chrono::steady_clock::duration duration,
+                           Solution *solution);
+
+#endif  // RELOCATE_H_
@@ -0,0 +1,252 @@
+#ifndef SCORE_CORE_H_
+#define SCORE_CORE_H_
+
+// Scoring core shared by lightning and full round solvers.
+//
+// Problem variants differ in whether pillars exist, whether closeness
+// extension applies, and whether volumes are available.  These are
+// template parameters here, so that each problem selects a specialized
+// inner loop once instead of testing features for every attendee and
+// musician pair.
+//
+// This header does not depend on either tree's Problem or XY types.
+// Callers copy attendee and pillar data into ScoreTables once, and pass
+// musician positions as ScorePoint arrays.
+
+#include<algorithm>
+#include<cmath>
+#include<vector>
+
+template<typename Real>
+struct ScorePoint
+{
+   Real x, y;
+};
+
+template<typename Real>
+struct ScoreTables
+{
+   // Replace attendee data.  AttendeeList is a container of objects with
+   // "position" and "tastes" fields, such as Problem::Attendee.
+   template<typename AttendeeList>
+   void SetAttendees(const AttendeeList &input, int instruments)
+   {
+      instrument_count = instruments;
+      attendees.clear();
+      tastes.clear();
+      attendees.reserve(input.size());
+      tastes.reserve(input.size() * instruments);
+      for(const auto &a : input)
+      {
+         attendees.push_back(
+            ScorePoint<Real>{static_cast<Real>(a.position.x),
+                             static_cast<Real>(a.position.y)});
+         for(int i = 0; i < instruments; i++)
+            tastes.push_back(static_cast<Real>(a.tastes[i]));
+      }
+   }
+
+   void AddPillar(double x, double y, double radius)
+   {
+      pillars.push_back(ScorePoint<Real>{static_cast<Real>(x),
+                                         static_cast<Real>(y)});
+      pillar_radius.push_back(static_cast<Real>(radius));
+   }
+
+   int instrument_count = 0;
+
+   // Attendee positions, in the same order as Problem::attendees().
+   std::vector<ScorePoint<Real>> attendees;
+
+   // Attendee tastes, attendees.size() rows of instrument_count entries.
+   std::vector<Real> tastes;
+
+   // Pillar positions and radius.
+   std::vector<ScorePoint<Real>> pillars;
+   std::vector<Real> pillar_radius;
+};
+
+// Minimum radius for blocking.
+static constexpr double kScoreBlockingRadius = 5;
+
+// Number of musicians tested together for blocking.
+static constexpr int kScoreBlockSize = 16;
+
+// Check if a line segment from u to v would intersect blocker 'b' of a
+// particular radius.  Returns true if so.
+//
+// Blocker is first checked against the bounding box enclosed by 'u' and
+// 'v', expanded by 'r'.  This is because the second check measures
+// distance to an infinite line, but we just want distance to a specific
+// segment.
+//
+// It's conceivable to create a case where the combination of these
+// two checks yields a false positive, by placing the blocking
+// obstacle behind 'v', with 'v' just inside the bounding box but just
+// outside of radius of 'b'.  This doesn't happen for musicians due to
+// the 10m radius limit, and doesn't happen for pillars because none
+// of the pillars are placed near the stage.
+template<typename Real>
+inline bool SegmentBlocked(const ScorePoint<Real> &u,
+                           const ScorePoint<Real> &v,
+                           const ScorePoint<Real> &b,
+                           Real r)
+{
+   if( b.x < std::min(u.x, v.x) - r || b.x > std::max(u.x, v.x) + r ||
+       b.y < std::min(u.y, v.y) - r || b.y > std::max(u.y, v.y) + r )
+   {
+      return false;
+   }
+
+   // Compare squared distance to line to avoid a division and sqrt:
+   //   |dx * (u.y - b.y) - dy * (u.x - b.x)| / hypot(dx, dy) < r
+   const Real dx = v.x - u.x;
+   const Real dy = v.y - u.y;
+   const Real n = dx * (u.y - b.y) - dy * (u.x - b.x);
+   return n * n < r * r * (dx * dx + dy * dy);
+}
+
+// Score contribution of a single unblocked attendee and musician pair.
+// 'q' is the product of volume and closeness factor.
+template<typename Real, bool kScaled>
+inline Real PairScore(Real taste, Real d2, Real q)
+{
+   const Real base = std::ceil(static_cast<Real>(1e6) * taste / d2);
+   if constexpr( kScaled )
+      return std::ceil(base * q);
+   else
+      return base;
+}
+
+template<typename Real, bool kPillars, bool kCloseness, bool kVolumes>
+struct ScoreCore
+{
+   // Compute score for the first 'attendee_limit' attendees.  'volumes'
+   // is ignored if kVolumes is false.  If 'order' is not null, musicians
+   // are visited in that order instead of by index.
+   static double LimitedScore(const ScoreTables<Real> &tables,
+                              const ScorePoint<Real> *musicians,
+                              const int *instruments,
+                              const Real *volumes,
+                              int musician_count,
+                              int attendee_limit,
+                              const int *order = nullptr)
+   {
+      const int limit = std::min(attendee_limit,
+                                 static_cast<int>(tables.attendees.size()));
+      double score = 0;
+
+      for(int k = 0; k < musician_count; k++)
+      {
+         const int i = order == nullptr ? k : order[k];
+         Real q = 1;
+         if constexpr( kVolumes )
+         {
+            if( volumes[i] == 0 )
+               continue;
+            q = volumes[i];
+         }
+         if constexpr( kCloseness )
+            q *= ClosenessFactor(musicians, instruments, musician_count, i);
+
+         const ScorePoint<Real> &musician = musicians[i];
+         const Real *taste = tables.tastes.data() + instruments[i];
+         for(int j = 0; j < limit; j++, taste += tables.instrument_count)
+         {
+            const ScorePoint<Real> &a = tables.attendees[j];
+            if( BlockedByMusician(musicians, musician_count, i, a) )
+               continue;
+            if constexpr( kPillars )
+            {
+               if( BlockedByPillar(tables, a, musician) )
+                  continue;
+            }
+
+            const Real dx = musician.x - a.x;
+            const Real dy = musician.y - a.y;
+            score += PairScore<Real, kCloseness || kVolumes>(
+               *taste, dx * dx + dy * dy, q);
+         }
+      }
+      return score;
+   }
+
+   // Compute closeness factor for a single musician 'm'.
+   static Real ClosenessFactor(const ScorePoint<Real> *musicians,
+                               const int *instruments,
+                               int musician_count,
+                               int m)
+   {
+      Real q = 1;
+      for(int i = 0; i < musician_count; i++)
+      {
+         if( i == m || instruments[i] != instruments[m] )
+            continue;
+         const Real d = std::hypot(musicians[i].x - musicians[m].x,
+                                   musicians[i].y - musicians[m].y);
+         if( d > 0 )
+            q += 1 / d;
+      }
+      return q;
+   }
+
+   // Check if any musician blocks 'a' with respect to attendee 'p'.
+   //
+   // Musicians are tested in blocks of kScoreBlockSize without branches,
+   // so that the compiler can vectorize each block, and the early exit
+   // is taken between blocks.  Single precision fits twice as many lanes
+   // per vector, which is where the float scorer gets its speedup.
+   static bool BlockedByMusician(const ScorePoint<Real> *musicians,
+                                 int musician_count,
+                                 int a,
+                                 const ScorePoint<Real> &p)
+   {
+      static constexpr Real kRadius = static_cast<Real>(kScoreBlockingRadius);
+      const ScorePoint<Real> &v = musicians[a];
+      const Real lo_x = std::min(p.x, v.x) - kRadius;
+      const Real hi_x = std::max(p.x, v.x) + kRadius;
+      const Real lo_y = std::min(p.y, v.y) - kRadius;
+      const Real hi_y = std::max(p.y, v.y) + kRadius;
+      const Real dx = v.x - p.x;
+      const Real dy = v.y - p.y;
+      const Real limit = kRadius * kRadius * (dx * dx + dy * dy);
+
+      // Same tests as SegmentBlocked, combined with bitwise operators.
+      int b = 0;
+      for(; b + kScoreBlockSize <= musician_count; b += kScoreBlockSize)
+      {
+         int hits = 0;
+         for(int k = b; k < b + kScoreBlockSize; k++)
+         {
+            const ScorePoint<Real> &q = musicians[k];
+            const Real n = dx * (p.y - q.y) - dy * (p.x - q.x);
+            hits += (q.x >= lo_x) & (q.x <= hi_x) &
+                    (q.y >= lo_y) & (q.y <= hi_y) &
+                    (n * n < limit) & (k != a);
+         }
+         if( hits != 0 )
+            return true;
+      }
+      for(; b < musician_count; b++)
+      {
+         if( b != a && SegmentBlocked(p, v, musicians[b], kRadius) )
+            return true;
+      }
+      return false;
+   }
+
+   // Check if any pillar blocks the line between 'u' and 'v'.
+   static bool BlockedByPillar(const ScoreTables<Real> &tables,
+                               const ScorePoint<Real> &u,
+                               const ScorePoint<Real> &v)
+   {
+      for(int i = 0; i < static_cast<int>(tables.pillars.size()); i++)
+      {
+         if( SegmentBlocked(u, v, tables.pillars[i], tables.pillar_radius[i]) )
+            return true;
+      }
+      return false;
+   }
+};
+
+#endif  // SCORE_CORE_H_
@@ -4,10 +4,29 @@
 #include<array>
 #include<chrono>
 #include<cmath>
+#include<limits>
+#include<memory>
 #include<random>
-
+#include<thread>
+
+#include"anneal.h"
+#include"assignment.h"
+#include"blockers.h"
+#include"cell_values.h"
+#include"delta_score.h"
+#include"elite_pool.h"
+#include"genetic.h"
 #include"grid.h"
+#include"hilbert.h"
 #include"intersect.h"
+#include"island_board.h"
+#include"move_journal.h"
+#include"parallel.h"
+#include"polish.h"
+#include"proposal.h"
+#include"relocate.h"
+#include"tiles.h"
+#include"transposition.h"
 
 #ifdef BENCHMARK
 #include<iostream>
@@ -27,18 +46,62 @@ static constexpr int kRandomGroupCount = 3;
 // Number of mutations per group.
 static constexpr int kMutationCount = 10;
 
-// Number of consecutive no-ops before randomizing all musicians.
+// Number of Lloyd iterations when partitioning musicians spatially.
+static constexpr int kKMeansIterations = 4;
+
+// Counters for each partition strategy, indexed by SolveOptions::Partition.
+static constexpr int kPartitionCounters[] =
+{
+   Solution::kRandomPartitions,
+   Solution::kSpatialPartitions,
+   Solution::kInstrumentPartitions,
+   Solution::kAttendeePartitions
+};
+static constexpr int kPartitionAcceptedCounters[] =
+{
+   Solution::kRandomPartitionsAccepted,
+   Solution::kSpatialPartitionsAccepted,
+   Solution::kInstrumentPartitionsAccepted,
+   Solution::kAttendeePartitionsAccepted
+};
+
+// Number of search evaluations between exact score checks, when using
+// approximate search scores.
+static constexpr int kScorerCheckInterval = 8;
+
+// Number of surrogate rejections between audits, where a rejected
+// candidate is scored anyway to estimate false negatives.
+static constexpr int kCascadeAuditInterval = 16;
+
+// Maximum fraction of search time spent reassigning instruments.
+static constexpr double kAssignmentShare = 0.1;
+
+// Number of consecutive no-ops before restarting from a perturbed elite.
 static constexpr int kMaxConsecutiveNoOps = 5;
 
+// Number of distinct placements to keep for restarts.
+static constexpr int kEliteCount = 8;
+
+// Minimum distance between elites, as a fraction of musician count.
+static constexpr double kEliteMinDistance = 0.1;
+
+// Fraction of musicians to move when restarting from an elite.
+static constexpr double kRestartPerturbation = 0.2;
+
 // Run for this much time before giving up.
 static constexpr std::chrono::seconds kRunDuration{60};
 
+// Time between migrations, when running multiple islands.
+static constexpr std::chrono::seconds kMigrationInterval{5};
+
+// Time limits for continuous polish after search.  Problems with pillars
+// also pay for closeness gradients and pillar visibility checks.
+static constexpr std::chrono::seconds kPolishDuration{1};
+static constexpr std::chrono::seconds kPillarPolishDuration{5};
+
 // Minimum radius from musician to edge or another musician.
 static constexpr double kMargin = 10;
 
-// Minimum radius for blocking.
-static constexpr double kBlockingRadius = 5;
-
 // Return this score in event of error.
 static constexpr double kErrorScore = -1e9;
 
@@ -49,43 +112,68 @@ static double DistanceSquared(const XY &a, const XY &b)
    return dx * dx + dy * dy;
 }
 
-// Check if any musician blocks 'a' with respect to audience 'p'.
-static bool BlockedByAnotherMusician(const std::vector<XY> &placements,
-                                     int a,
-                                     const XY &p)
+// Scoring cores for the two problem variants.  Closeness extension is
+// enabled exactly when the problem has pillars, so the other two
+// combinations of these features never occur.
+template<typename Real>
+using PillarScoreCore = ScoreCore<Real, true, true, true>;
+template<typename Real>
+using PlainScoreCore = ScoreCore<Real, false, false, true>;
+
+// Return musician indices sorted along a Hilbert curve.
+static std::vector<int> HilbertOrder(const Problem &problem,
+                                     const std::vector<XY> &placements)
 {
-   for(int b = 0; b < static_cast<int>(placements.size()); b++)
+   std::vector<std::pair<uint32_t, int>> keys;
+   keys.reserve(placements.size());
+   for(int i = 0; i < static_cast<int>(placements.size()); i++)
    {
-      if( b == a )
-         continue;
-      if( IsBlocked(p, placements[a], placements[b], kBlockingRadius) )
-         return true;
+      keys.push_back(std::make_pair(
+         HilbertIndex(placements[i].x, placements[i].y,
+                      problem.room_size().x, problem.room_size().y),
+         i));
    }
-   return false;
+   std::sort(keys.begin(), keys.end());
+
+   std::vector<int> order;
+   order.reserve(keys.size());
+   for(const auto &k : keys)
+      order.push_back(k.second);
+   return order;
 }
 
-// Compute closeness factor for a single musician 'm'.
-static double ClosenessFactor(const Problem &problem,
-                              int m,
-                              const std::vector<XY> &placements)
+// Run specialized scoring core for problem features.
+template<typename Real>
+static double RunScoreCore(const Problem &problem,
+                           const ScoreTables<Real> &tables,
+                           const ScorePoint<Real> *musicians,
+                           const Real *volumes,
+                           int attendee_count,
+                           const std::vector<int> &order)
 {
-   if( !problem.UseClosenessExtension() )
-      return 1;
-
-   double q = 1;
-   for(int i = 0; i < static_cast<int>(problem.musicians().size()); i++)
-   {
-      if( i == m || problem.musicians()[i] != problem.musicians()[m] )
-         continue;
-      const double d = hypot(placements[i].x - placements[m].x,
-                             placements[i].y - placements[m].y);
-      if( d > 0 )
-         q += 1 / d;
-   }
-   return q;
+   double (*score_function)(const ScoreTables<Real> &,
+                            const ScorePoint<Real> *,
+                            const int *,
+                            const Real *,
+                            int,
+                            int,
+                            const int *);
+   score_function = problem.pillars().empty()
+      ? PlainScoreCore<Real>::LimitedScore
+      : PillarScoreCore<Real>::LimitedScore;
+   return score_function(tables,
+                         musicians,
+                         problem.musicians().data(),
+                         volumes,
+                         static_cast<int>(problem.musicians().size()),
+                         attendee_count,
+                         order.empty() ? nullptr : order.data());
 }
 
 // Compute scores using just the top few audiences.
+//
+// Problem features are resolved here once per call, so that the inner
+// loops are specialized for each problem variant.
 static double ComputeLimitedScore(const Problem &problem,
                                   const std::vector<XY> &placements,
                                   const std::vector<double> &volumes,
@@ -95,30 +183,15 @@ static double ComputeLimitedScore(const Problem &problem,
       const auto start_time = std::chrono::steady_clock::now();
    #endif
 
-   const int limit = std::min(attendee_count,
-                              static_cast<int>(problem.attendees().size()));
-   double score = 0;
-
-   for(int i = 0; i < static_cast<int>(problem.musicians().size()); i++)
-   {
-      const XY &musician = placements[i];
-      if( volumes[i] == 0 )
-         continue;
-      const double q =
-         volumes[i] * ClosenessFactor(problem, i, placements);
-
-      const int instrument = problem.musicians()[i];
-      for(int j = 0; j < limit; j++)
-      {
-         const Problem::Attendee &a = problem.attendees()[j];
-         if( BlockedLineOfSight(problem, placements, a.position, i) )
-            continue;
-
-         score +=
-            std::ceil(std::ceil(1e6 * a.tastes[instrument] /
-                                DistanceSquared(musician, a.position)) * q);
-      }
-   }
+   std::vector<int> order;
+   if( problem.spatial_order() )
+      order = HilbertOrder(problem, placements);
+   const double score = RunScoreCore(problem,
+                                     problem.score_tables(),
+                                     placements.data(),
+                                     volumes.data(),
+                                     attendee_count,
+                                     order);
 
    #ifdef BENCHMARK
       const std::chrono::duration<double> elapsed =
@@ -128,147 +201,317 @@ static double ComputeLimitedScore(const Problem &problem,
    return score;
 }
 
-// Move a single musician to a particular (column, row).
-static void MoveMusician(
-   Grid *grid, std::vector<XY> *placements, int m, int column, int row)
+// Same as ComputeLimitedScore, but computed in single precision from
+// float copies of placements and volumes kept by the caller.  This is
+// faster but not exact, and is meant for ranking candidates during
+// search.  Final scores should always come from ComputeLimitedScore.
+static double ComputeFloatLimitedScore(const Problem &problem,
+                                       const MoveJournal &journal,
+                                       const std::vector<float> &volumes,
+                                       int attendee_count)
+{
+   std::vector<int> order;
+   if( problem.spatial_order() )
+      order = HilbertOrder(problem, journal.placements());
+   return RunScoreCore(problem,
+                       problem.float_score_tables(),
+                       journal.float_placements().data(),
+                       volumes.data(),
+                       attendee_count,
+                       order);
+}
+
+// Compute score used for ranking candidates during search.
+// 'float_volumes' is only used with options.float_scorer, in which case
+// journal must also be tracking float placements.
+static double ComputeSearchScore(const Problem &problem,
+                                 const SolveOptions &options,
+                                 const MoveJournal &journal,
+                                 const std::vector<double> &volumes,
+                                 const std::vector<float> &float_volumes)
 {
-   const auto [old_x, old_y] = grid->FromXY((*placements)[m]);
-   grid->Set(old_x, old_y, 0);
-   grid->Set(column, row, 1);
-   (*placements)[m] = grid->ToXY(column, row);
+   return options.float_scorer
+      ? ComputeFloatLimitedScore(problem, journal, float_volumes,
+                                 kSampleSize)
+      : ComputeLimitedScore(problem, journal.placements(), volumes,
+                            kSampleSize);
 }
 
-// Move musicians in selected group.
-static void MoveMusicianGroup(const std::vector<int> &movable_group,
+// Compute blocking-free surrogate score from cell values, with closeness
+// and volume.  This is much cheaper than ComputeLimitedScore, and is used
+// to screen candidates before scoring them with blocking.
+static double SurrogateScore(const Problem &problem,
+                             const CellValues &values,
+                             const std::vector<Cell> &cells,
+                             const std::vector<XY> &placements,
+                             const std::vector<double> &volumes)
+{
+   double score = 0;
+   for(int m = 0; m < static_cast<int>(cells.size()); m++)
+   {
+      if( volumes[m] == 0 )
+         continue;
+      const double closeness = problem.UseClosenessExtension()
+         ? PillarScoreCore<double>::ClosenessFactor(
+              placements.data(), problem.musicians().data(),
+              static_cast<int>(placements.size()), m)
+         : 1;
+      score += volumes[m] * closeness *
+               values.PillarAwareValue(cells[m], problem.musicians()[m]);
+   }
+   return score;
+}
+
+// Same as ComputeSearchScore, but reuse scores of placements seen before
+// if a transposition table is available.
+static double LookupSearchScore(const Problem &problem,
+                                const SolveOptions &options,
+                                const MoveJournal &journal,
+                                const std::vector<double> &volumes,
+                                const std::vector<float> &float_volumes,
+                                TranspositionTable *transpositions,
+                                Solution *solution)
+{
+   if( transpositions == nullptr )
+   {
+      return ComputeSearchScore(problem, options, journal, volumes,
+                                float_volumes);
+   }
+
+   double score;
+   solution->counters[Solution::kTranspositionLookups]++;
+   if( transpositions->Lookup(journal.hash(), &score) )
+   {
+      solution->counters[Solution::kTranspositionHits]++;
+      return score;
+   }
+   score = ComputeSearchScore(problem, options, journal, volumes,
+                              float_volumes);
+   transpositions->Insert(journal.hash(), score);
+   return score;
+}
+
+// Move musicians in selected group.  Destination cells are drawn from
+// sampler if available, otherwise they are uniformly random.
+static void MoveMusicianGroup(const Problem &problem,
+                              const std::vector<int> &movable_group,
                               int group,
-                              Grid *grid,
-                              std::vector<XY> *placements)
+                              ProposalSampler *sampler,
+                              std::default_random_engine &rng,
+                              MoveJournal *journal,
+                              Solution *solution)
 {
-   grid->ShufflePoints();
-   int point_index = 0;
    for(int m = 0; m < static_cast<int>(movable_group.size()); m++)
    {
       if( movable_group[m] != group )
          continue;
 
-      // Find next unoccupied point.
-      //
-      // All problems have spare room, so this should not be an infinite loop.
-      while( true )
-      {
-         point_index = (point_index + 1) % grid->points().size();
-         const auto [x, y] = grid->points()[point_index];
-         if( grid->Get(x, y) != 0 )
-            continue;
-
-         // Apply movement.
-         MoveMusician(grid, placements, m, x, y);
-         break;
-      }
+      // All problems have spare room, so there is always a free cell.
+      solution->counters[Solution::kDanceProposals]++;
+      journal->Move(m, sampler != nullptr
+                       ? sampler->Sample(problem.musicians()[m],
+                                         journal->grid(), rng)
+                       : journal->grid()->RandomFreeCell());
    }
 }
 
-// Undo the movements in new_placement and restore them to original_placement.
-static void UndoMovements(const std::vector<XY> &original_placement,
-                          std::vector<XY> *new_placement,
-                          Grid *grid)
+// Assign each movable musician to one of the first 'count' clusters of
+// movable musicians, using k-means on placements.
+static void SpatialClusters(const std::vector<XY> &placements,
+                            const std::vector<int> &movable,
+                            int count,
+                            std::default_random_engine &rng,
+                            std::vector<int> *cluster)
 {
-   for(int m = static_cast<int>(original_placement.size()); m-- > 0;)
+   // Seed centers with distinct random musicians.
+   std::vector<XY> centers;
+   std::vector<int> seeds = movable;
+   for(int i = 0; i < count && i < static_cast<int>(seeds.size()); i++)
+   {
+      std::uniform_int_distribution<> select(
+         i, static_cast<int>(seeds.size()) - 1);
+      std::swap(seeds[i], seeds[select(rng)]);
+      centers.push_back(placements[seeds[i]]);
+   }
+
+   std::vector<XY> sums(centers.size());
+   std::vector<int> sizes(centers.size());
+   for(int iteration = 0; iteration < kKMeansIterations; iteration++)
    {
-      if( original_placement[m].x != (*new_placement)[m].x ||
-          original_placement[m].y != (*new_placement)[m].y )
+      std::fill(sums.begin(), sums.end(), XY{0, 0});
+      std::fill(sizes.begin(), sizes.end(), 0);
+      for(int m : movable)
       {
-         const auto [x, y] = grid->FromXY(original_placement[m]);
-         MoveMusician(grid, new_placement, m, x, y);
+         int nearest = 0;
+         for(int i = 1; i < static_cast<int>(centers.size()); i++)
+         {
+            if( DistanceSquared(placements[m], centers[i]) <
+                DistanceSquared(placements[m], centers[nearest]) )
+            {
+               nearest = i;
+            }
+         }
+         (*cluster)[m] = nearest;
+         sums[nearest].x += placements[m].x;
+         sums[nearest].y += placements[m].y;
+         sizes[nearest]++;
+      }
+      for(int i = 0; i < static_cast<int>(centers.size()); i++)
+      {
+         if( sizes[i] > 0 )
+            centers[i] = XY{sums[i].x / sizes[i], sums[i].y / sizes[i]};
       }
    }
 }
 
-// Apply movements in new_placement.
-static void ApplyMovements(std::vector<XY> *placements,
-                           const std::vector<XY> &new_placement,
-                           Grid *grid)
+// Divide movable musicians into kRandomGroupCount groups, numbered from
+// 1.  Musicians with movable_group of zero are not movable and are left
+// alone.  Returns false if any group is empty.
+//
+// Random partition scatters each group across the stage.  The other
+// strategies keep musicians that interact in the same group: spatial
+// partition clusters placements with k-means, instrument partition keeps
+// musicians of the same instrument together, and attendee partition
+// keeps musicians together if they have the same dominant attendee, the
+// one with largest |taste|/d^2 among sampled attendees.
+static bool PartitionMovable(const Problem &problem,
+                             SolveOptions::Partition partition,
+                             const std::vector<XY> &placements,
+                             std::default_random_engine &rng,
+                             std::vector<int> *movable_group)
 {
-   for(int m = 0; m < static_cast<int>(new_placement.size()); m++)
+   const int musician_count = static_cast<int>(movable_group->size());
+   std::uniform_int_distribution<> group_select(1, kRandomGroupCount);
+   std::vector<int> movable;
+   for(int m = 0; m < musician_count; m++)
    {
-      if( (*placements)[m].x != new_placement[m].x ||
-          (*placements)[m].y != new_placement[m].y )
-      {
-         const auto [x, y] = grid->FromXY(new_placement[m]);
-         MoveMusician(grid, placements, m, x, y);
-      }
+      if( (*movable_group)[m] != 0 )
+         movable.push_back(m);
+   }
+
+   switch( partition )
+   {
+      case SolveOptions::kRandomPartition:
+      case SolveOptions::kMixedPartition:
+         for(int m : movable)
+            (*movable_group)[m] = group_select(rng);
+         break;
+
+      case SolveOptions::kSpatialPartition:
+         SpatialClusters(placements, movable, kRandomGroupCount, rng,
+                         movable_group);
+         for(int m : movable)
+            (*movable_group)[m]++;
+         break;
+
+      case SolveOptions::kInstrumentPartition:
+         {
+            std::vector<int> instrument_group(problem.instruments().size());
+            for(int &g : instrument_group)
+               g = group_select(rng);
+            for(int m : movable)
+               (*movable_group)[m] = instrument_group[problem.musicians()[m]];
+         }
+         break;
+
+      case SolveOptions::kAttendeePartition:
+         {
+            const int attendee_count = std::min(
+               kSampleSize, static_cast<int>(problem.attendees().size()));
+            std::vector<int> attendee_group(attendee_count, 0);
+            for(int m : movable)
+            {
+               const int instrument = problem.musicians()[m];
+               int dominant = 0;
+               double dominant_weight = -1;
+               for(int j = 0; j < attendee_count; j++)
+               {
+                  const Problem::Attendee &a = problem.attendees()[j];
+                  const double weight = std::fabs(a.tastes[instrument]) /
+                     DistanceSquared(a.position, placements[m]);
+                  if( weight > dominant_weight )
+                  {
+                     dominant = j;
+                     dominant_weight = weight;
+                  }
+               }
+               if( attendee_group[dominant] == 0 )
+                  attendee_group[dominant] = group_select(rng);
+               (*movable_group)[m] = attendee_group[dominant];
+            }
+         }
+         break;
    }
+
+   std::array<int, kRandomGroupCount> movable_count;
+   movable_count.fill(0);
+   for(int m : movable)
+      movable_count[(*movable_group)[m] - 1]++;
+   return std::find(movable_count.begin(), movable_count.end(), 0) ==
+          movable_count.end();
 }
 
 // Optionally move a single musician by integrating taste forces.
 //
 // Returns true if movement was made.
 static bool IntegrateTasteForces(const Problem &problem,
+                                 const CellValues &values,
                                  int m,
-                                 std::vector<XY> *placements,
-                                 Grid *grid)
+                                 MoveJournal *journal)
 {
-   double force_x = 0, force_y = 0;
-
-   XY position = (*placements)[m];
-   const int instrument = problem.musicians()[m];
-   for(const Problem::Attendee &a : problem.attendees())
-   {
-      const double dx = a.position.x - position.x;
-      const double dy = a.position.y - position.y;
-      const double scale = a.tastes[instrument] / (dx * dx + dy * dy);
-      force_x += scale * dx;
-      force_y += scale * dy;
-   }
+   const Cell &current = journal->cells()[m];
+   const XY force = values.Force(current, problem.musicians()[m]);
 
-   if( force_x < -1 )
+   Cell target = current;
+   if( force.x < -1 )
    {
-      position.x -= Grid::kCellSize;
+      target.column--;
    }
-   else if( force_x > 1 )
+   else if( force.x > 1 )
    {
-      position.x += Grid::kCellSize;
+      target.column++;
    }
-   if( force_y < -1 )
+   if( force.y < -1 )
    {
-      position.y -= Grid::kCellSize;
+      target.row--;
    }
-   else if( force_y > 1 )
+   else if( force.y > 1 )
    {
-      position.y += Grid::kCellSize;
+      target.row++;
    }
 
-   const auto [test_x, test_y] = grid->FromXY(position);
-   if( test_x < 0 || test_x >= grid->columns() )
-      position.x = (*placements)[m].x;
-   if( test_y < 0 || test_y >= grid->rows() )
-      position.y = (*placements)[m].y;
-   if( position.x == (*placements)[m].x && position.y == (*placements)[m].y )
-      return false;
-
-   const auto [grid_x, grid_y] = grid->FromXY(position);
-   if( grid->Get(grid_x, grid_y) != 0 )
+   const Grid *grid = journal->grid();
+   if( target.column < 0 || target.column >= grid->columns() )
+      target.column = current.column;
+   if( target.row < 0 || target.row >= grid->rows() )
+      target.row = current.row;
+   if( target == current || grid->Get(target) != 0 )
       return false;
 
-   MoveMusician(grid, placements, m, grid_x, grid_y);
+   journal->Move(m, target);
    return true;
 }
 
 // Set initial musician positions by integrating forces.
 static void SetInitialPositions(const Problem &problem,
+                                const CellValues &values,
                                 Solution *solution,
-                                Grid *grid,
+                                MoveJournal *journal,
                                 std::default_random_engine &rng,
                                 int max_steps)
 {
-   // Start with random positions and populate grid.
+   // Start with random positions and populate grid.  Each musician gets
+   // the better of two random cells, according to precomputed values.
+   Grid *grid = journal->grid();
    grid->Reset();
    const int musician_count = static_cast<int>(problem.musicians().size());
    for(int i = 0; i < musician_count; i++)
    {
-      const std::pair<int, int> &p = grid->points()[i];
-      solution->placements[i] = grid->ToXY(p.first, p.second);
-      grid->Set(p.first, p.second, 1);
+      const int instrument = problem.musicians()[i];
+      const Cell a = grid->RandomFreeCell();
+      const Cell b = grid->RandomFreeCell();
+      journal->Place(i, values.PillarAwareValue(a, instrument) <
+                        values.PillarAwareValue(b, instrument) ? b : a);
    }
 
    // Try integrating forces from audiences.
@@ -285,12 +528,13 @@ static void SetInitialPositions(const Problem &problem,
       bool attempted_movement = false;
       for(int m : musician_index)
       {
-         if( IntegrateTasteForces(problem, m, &(solution->placements), grid) )
+         if( IntegrateTasteForces(problem, values, m, journal) )
          {
             attempted_movement = true;
             solution->counters[Solution::kInitialMovements]++;
          }
       }
+      journal->Commit();
 
       // Stop when nobody is moving anymore.
       if( !attempted_movement )
@@ -298,79 +542,216 @@ static void SetInitialPositions(const Problem &problem,
    }
 }
 
-// Randomly dance some subset of musicians.
+// Restart search from a randomly selected elite, with a fraction of its
+// musicians moved to new cells.
+static void RestartFromElite(const Problem &problem,
+                             const ElitePool &elites,
+                             ProposalSampler *sampler,
+                             std::default_random_engine &rng,
+                             MoveJournal *journal)
+{
+   std::uniform_int_distribution<> elite_select(0, elites.size() - 1);
+   journal->Restore(elites.elite(elite_select(rng)).cells);
+
+   std::bernoulli_distribution perturb(kRestartPerturbation);
+   for(int m = 0; m < static_cast<int>(problem.musicians().size()); m++)
+   {
+      if( !perturb(rng) )
+         continue;
+      journal->Move(m, sampler != nullptr
+                       ? sampler->Sample(problem.musicians()[m],
+                                         journal->grid(), rng)
+                       : journal->grid()->RandomFreeCell());
+   }
+   journal->Commit();
+}
+
+// Randomly dance some subset of musicians for a fixed amount of time.
+//
+// Trial movements are applied to solution->placements directly through
+// the journal, and undone via rollback.
+//
+// When the search stalls, the current placements are offered to 'elites',
+// and search restarts from a perturbed copy of one of the elites.  The
+// pool is kept across calls, so that elites found in earlier epochs can
+// still be restored.
+// If options.assignment is set, instruments in the restarted placements
+// are then reassigned with ReassignInstruments, as long as
+// 'assignment_budget' allows.
+// Best elite is restored at the end.
+//
+// If 'transpositions' is not null, search scores are cached by placement
+// hash, so that placements revisited by group moves and restarts are not
+// rescored.
 static void RandomDance(const Problem &problem,
+                        const SolveOptions &options,
+                        const CellValues &values,
+                        ProposalSampler *sampler,
+                        TranspositionTable *transpositions,
+                        AssignmentBudget *assignment_budget,
+                        ElitePool *elites,
                         Solution *solution,
-                        Grid *grid,
-                        std::default_random_engine &rng)
+                        MoveJournal *journal,
+                        std::default_random_engine &rng,
+                        std::chrono::steady_clock::duration duration)
 {
-   double best_score = ComputeLimitedScore(problem,
-                                           solution->placements,
-                                           solution->volumes,
-                                           kSampleSize);
+   // With the float scorer, keep single precision copies of placements
+   // and volumes, so that evaluations do not convert them.  Volumes do
+   // not change during the dance.
+   std::vector<ScorePoint<float>> float_placements;
+   std::vector<float> float_volumes;
+   if( options.float_scorer )
+   {
+      journal->set_float_placements(&float_placements);
+      float_volumes.assign(solution->volumes.begin(),
+                           solution->volumes.end());
+   }
+
+   double best_score =
+      LookupSearchScore(problem, options, *journal, solution->volumes,
+                        float_volumes, transpositions, solution);
+
+   // If search scores are approximate, periodically check candidates
+   // against the exact scorer to see if they would be ranked differently.
+   double exact_best_score = options.float_scorer
+      ? ComputeLimitedScore(problem, solution->placements, solution->volumes,
+                            kSampleSize)
+      : best_score;
+   int evaluations = 0;
+
+   // If candidates are screened with a cascade, keep surrogate and full
+   // scores of the current placements for comparison.
+   //
+   // After a restart, the full score of the new basin is left unknown
+   // rather than paying for another ComputeScore.  Like best_score, the
+   // new basin only competes against itself, so the first full check
+   // after a restart passes and anchors the full score.
+   double surrogate_best_score = 0, full_best_score = 0;
+   const auto reset_cascade = [&]()
+   {
+      if( !options.cascade )
+         return;
+      surrogate_best_score =
+         SurrogateScore(problem, values, journal->cells(),
+                        solution->placements, solution->volumes);
+      full_best_score = -std::numeric_limits<double>::infinity();
+   };
+   reset_cascade();
+   if( options.cascade )
+   {
+      full_best_score =
+         ComputeScore(problem, solution->placements, solution->volumes);
+   }
 
    // Mutability state for each musician.
    const int musician_count = static_cast<int>(problem.musicians().size());
    std::vector<int> movable_group(musician_count, 1);
 
-   std::uniform_int_distribution<> group_select(1, kRandomGroupCount);
-   std::uniform_int_distribution<> init_steps(0, kMaxInitIterationSteps / 2);
+   std::uniform_int_distribution<> strategy_select(
+      0, SolveOptions::kMixedPartition - 1);
 
    // Temporary states that are used within the loop, but declared
    // outside the loop to avoid repeated allocations.
-   std::vector<XY> new_placement;
-   std::array<int, kRandomGroupCount> movable_count;
    std::array<double, kRandomGroupCount> group_best_score;
-   std::array<std::vector<XY>, kRandomGroupCount> group_best_placement;
+   std::array<std::vector<MoveJournal::Entry>, kRandomGroupCount>
+      group_best_moves;
 
    // Try random movements for a fixed amount of time.
    int consecutive_no_ops = 0;
    for(const auto start_time = std::chrono::steady_clock::now();
-       std::chrono::steady_clock::now() - start_time < kRunDuration;
+       std::chrono::steady_clock::now() - start_time < duration;
        solution->counters[Solution::kDanceIterations]++)
    {
-      // Divide the currently movable musicians into a few groups.
-      movable_count.fill(0);
-      int empty_groups = kRandomGroupCount;
-      for(int i = 0; i < musician_count; i++)
+      // Divide the currently movable musicians into a few groups.  If a
+      // structured partition leaves a group empty, fall back to random
+      // partition for this iteration.
+      SolveOptions::Partition partition =
+         options.partition == SolveOptions::kMixedPartition
+            ? static_cast<SolveOptions::Partition>(strategy_select(rng))
+            : options.partition;
+      bool partitioned = PartitionMovable(problem, partition,
+                                          solution->placements, rng,
+                                          &movable_group);
+      if( !partitioned && partition != SolveOptions::kRandomPartition )
       {
-         if( movable_group[i] != 0 )
-         {
-            const int group = group_select(rng);
-            movable_group[i] = group;
-            if( movable_count[group - 1] == 0 )
-               empty_groups--;
-            movable_count[group - 1]++;
-         }
+         partition = SolveOptions::kRandomPartition;
+         partitioned = PartitionMovable(problem, partition,
+                                        solution->placements, rng,
+                                        &movable_group);
       }
 
-      // If any group is empty, it means we have too few movable
+      // If any group is still empty, it means we have too few movable
       // musicians.  Reset mutability state and try again.
-      if( empty_groups > 0 )
+      if( !partitioned )
       {
          std::fill(movable_group.begin(), movable_group.end(), 1);
          continue;
       }
+      solution->counters[kPartitionCounters[partition]]++;
 
       // Apply movements to selected musicians in each group.
-      new_placement = solution->placements;
       group_best_score.fill(best_score);
       for(int group = 0; group < kRandomGroupCount; group++)
       {
          for(int mutation = 0; mutation < kMutationCount; mutation++)
          {
-            MoveMusicianGroup(movable_group, group + 1, grid, &new_placement);
-            const double new_score = ComputeLimitedScore(problem,
-                                                         new_placement,
-                                                         solution->volumes,
-                                                         kSampleSize);
+            MoveMusicianGroup(problem, movable_group, group + 1, sampler,
+                              rng, journal, solution);
+
+            // Skip candidates whose surrogate score falls too far below
+            // the current placements, auditing a few of them.
+            if( options.cascade )
+            {
+               solution->counters[Solution::kSurrogateChecks]++;
+               const double surrogate_score =
+                  SurrogateScore(problem, values, journal->cells(),
+                                 solution->placements, solution->volumes);
+               if( surrogate_score < surrogate_best_score -
+                      options.cascade_tolerance *
+                      std::fabs(surrogate_best_score) )
+               {
+                  if( ++solution->counters[Solution::kSurrogateRejections] %
+                      kCascadeAuditInterval == 0 )
+                  {
+                     solution->counters[Solution::kSurrogateAudits]++;
+                     if( ComputeSearchScore(problem, options, *journal,
+                                            solution->volumes,
+                                            float_volumes) >
+                         group_best_score[group] )
+                     {
+                        solution->counters[
+                           Solution::kSurrogateFalseNegatives]++;
+                     }
+                  }
+                  journal->Rollback();
+                  continue;
+               }
+            }
+
+            const double new_score =
+               LookupSearchScore(problem, options, *journal,
+                                 solution->volumes, float_volumes,
+                                 transpositions, solution);
+            if( options.float_scorer &&
+                ++evaluations % kScorerCheckInterval == 0 )
+            {
+               const double exact_score =
+                  ComputeLimitedScore(problem, solution->placements,
+                                      solution->volumes, kSampleSize);
+               solution->counters[Solution::kScorerChecks]++;
+               if( (best_score < new_score) !=
+                   (exact_best_score < exact_score) )
+               {
+                  solution->counters[Solution::kScorerDisagreements]++;
+               }
+            }
             if( group_best_score[group] < new_score )
             {
                group_best_score[group] = new_score;
-               group_best_placement[group] = new_placement;
+               group_best_moves[group] = journal->entries();
             }
 
-            UndoMovements(solution->placements, &new_placement, grid);
+            journal->Rollback();
          }
       }
 
@@ -383,13 +764,42 @@ static void RandomDance(const Problem &problem,
       }
 
       // Apply mutation from best group if they improved upon the score.
-      if( best_score < group_best_score[best_group] )
+      // With a cascade, the mutation must also improve the score over all
+      // attendees.
+      bool improved = best_score < group_best_score[best_group];
+      if( improved )
       {
-         // Apply mutation from best group.
-         ApplyMovements(&(solution->placements),
-                        group_best_placement[best_group],
-                        grid);
+         journal->Replay(group_best_moves[best_group]);
+         if( options.cascade )
+         {
+            solution->counters[Solution::kFullChecks]++;
+            const double full_score = ComputeScore(
+               problem, solution->placements, solution->volumes);
+            if( full_score > full_best_score )
+            {
+               full_best_score = full_score;
+               surrogate_best_score =
+                  SurrogateScore(problem, values, journal->cells(),
+                                 solution->placements, solution->volumes);
+            }
+            else
+            {
+               solution->counters[Solution::kFullCheckRejections]++;
+               journal->Rollback();
+               improved = false;
+            }
+         }
+      }
+      if( improved )
+      {
+         journal->Commit();
          best_score = group_best_score[best_group];
+         if( options.float_scorer )
+         {
+            exact_best_score =
+               ComputeLimitedScore(problem, solution->placements,
+                                   solution->volumes, kSampleSize);
+         }
 
          // Update stats for what we moved.
          for(int g : movable_group)
@@ -397,14 +807,43 @@ static void RandomDance(const Problem &problem,
             if( g == best_group + 1 )
                solution->counters[Solution::kDanceMovements]++;
          }
+         solution->counters[kPartitionAcceptedCounters[partition]]++;
+         consecutive_no_ops = 0;
       }
       else
       {
          consecutive_no_ops++;
          if( consecutive_no_ops >= kMaxConsecutiveNoOps )
          {
-            SetInitialPositions(problem, solution, grid, rng, init_steps(rng));
+            // Save current basin and restart from a perturbed elite.
+            // The new basin is scored on its own, rather than competing
+            // against the best score from the old one.
+            elites->Offer(best_score, journal->cells());
+            RestartFromElite(problem, *elites, sampler, rng, journal);
+            if( options.assignment && assignment_budget->Available() )
+            {
+               solution->counters[Solution::kReassignments]++;
+               if( assignment_budget->Reassign(problem, values,
+                                               solution->volumes, rng,
+                                               journal) )
+               {
+                  solution->counters[Solution::kReassignmentsKept]++;
+               }
+            }
+            best_score = LookupSearchScore(problem, options, *journal,
+                                           solution->volumes, float_volumes,
+                                           transpositions, solution);
+            if( options.float_scorer )
+            {
+               exact_best_score =
+                  ComputeLimitedScore(problem, solution->placements,
+                                      solution->volumes, kSampleSize);
+            }
+            reset_cascade();
+            std::fill(movable_group.begin(), movable_group.end(), 1);
+            consecutive_no_ops = 0;
             solution->counters[Solution::kDanceResets]++;
+            continue;
          }
       }
 
@@ -419,6 +858,15 @@ static void RandomDance(const Problem &problem,
             movable_group[m] = 0;
       }
    }
+
+   // Keep the best placements seen, which may be from an earlier basin.
+   if( elites->size() > 0 )
+   {
+      const ElitePool::Elite &best = elites->elite(elites->best());
+      if( best_score < best.score )
+         journal->Restore(best.cells);
+   }
+   journal->set_float_placements(nullptr);
 }
 
 // Sanity check solution, returns true if there are no errors.
@@ -485,31 +933,257 @@ static bool SanityCheck(const Problem &problem, const Solution &solution)
    return status;
 }
 
-// Set volumes for each musician while holding positions fixed.
-static void AdjustVolumes(const Problem &problem, Solution *solution)
+// Set volumes for each musician while holding positions fixed.  Returns
+// score with the new volumes, and sets 'old_score' to score with the
+// volumes on entry, if not null.  Both match ComputeScore exactly.
+//
+// Visibility and closeness depend only on placements, so each visible
+// pair's base score is computed once and scaled by both old and maximum
+// volume.  Closeness factors are accumulated once per pair of musicians
+// with the same instrument, adding terms in the same order as ScoreCore.
+static double AdjustVolumes(const Problem &problem,
+                            Solution *solution,
+                            double *old_score)
 {
-   for(int i = 0; i < static_cast<int>(problem.musicians().size()); i++)
+   typedef ScoreCore<double, true, false, false> Core;
+   const int musician_count = static_cast<int>(problem.musicians().size());
+   const int attendee_count = static_cast<int>(problem.attendees().size());
+   const ScoreTables<double> &tables = problem.score_tables();
+   std::vector<ScorePoint<double>> musicians;
+   musicians.reserve(musician_count);
+   for(const XY &p : solution->placements)
+      musicians.push_back(ScorePoint<double>{p.x, p.y});
+
+   std::vector<double> closeness(musician_count, 1);
+   if( problem.UseClosenessExtension() )
    {
-      const XY &musician = solution->placements[i];
-
-      // Include maximum volume 10 in adjustment factor, to avoid the second
-      // ceil() from dropping precision.  We want to find the impact of a
-      // musician at maximum volume before decide whether to mute them.
-      const double q = 10 * ClosenessFactor(problem, i, solution->placements);
+      std::vector<std::vector<int>> players(tables.instrument_count);
+      for(int i = 0; i < musician_count; i++)
+         players[problem.musicians()[i]].push_back(i);
+      for(const std::vector<int> &group : players)
+      {
+         for(int a = 0; a < static_cast<int>(group.size()); a++)
+         {
+            const XY &p = solution->placements[group[a]];
+            for(int b = a + 1; b < static_cast<int>(group.size()); b++)
+            {
+               const XY &q = solution->placements[group[b]];
+               const double d = std::hypot(q.x - p.x, q.y - p.y);
+               if( d > 0 )
+               {
+                  closeness[group[a]] += 1 / d;
+                  closeness[group[b]] += 1 / d;
+               }
+            }
+         }
+      }
+   }
 
-      const int instrument = problem.musicians()[i];
-      double contribution = 0;
-      for(const Problem::Attendee &a : problem.attendees())
+   // Include maximum volume 10 in adjustment factor, to avoid the second
+   // ceil() from dropping precision.  We want to find the impact of a
+   // musician at maximum volume before decide whether to mute them.
+   std::vector<double> old_contribution(musician_count);
+   std::vector<double> max_contribution(musician_count);
+   ParallelFor(musician_count, [&](int i)
+   {
+      const ScorePoint<double> &musician = musicians[i];
+      const double old_q = solution->volumes[i] * closeness[i];
+      const double max_q = 10 * closeness[i];
+      const double *taste = tables.tastes.data() + problem.musicians()[i];
+      double old_sum = 0, max_sum = 0;
+      for(int j = 0; j < attendee_count; j++, taste += tables.instrument_count)
       {
-         if( BlockedLineOfSight(problem, solution->placements, a.position, i) )
+         const ScorePoint<double> &a = tables.attendees[j];
+         if( Core::BlockedByMusician(musicians.data(), musician_count, i, a) ||
+             Core::BlockedByPillar(tables, a, musician) )
+         {
             continue;
-         contribution +=
-            std::ceil(std::ceil(1e6 * a.tastes[instrument] /
-                                DistanceSquared(musician, a.position)) * q);
+         }
+         const double dx = musician.x - a.x;
+         const double dy = musician.y - a.y;
+         const double base = PairScore<double, false>(
+            *taste, dx * dx + dy * dy, 1);
+         old_sum += std::ceil(base * old_q);
+         max_sum += std::ceil(base * max_q);
+      }
+      old_contribution[i] = solution->volumes[i] == 0 ? 0 : old_sum;
+      max_contribution[i] = max_sum;
+   });
+
+   double score = 0, old_sum = 0;
+   for(int i = 0; i < musician_count; i++)
+   {
+      old_sum += old_contribution[i];
+      if( max_contribution[i] < 0 )
+      {
+         solution->volumes[i] = 0;
+      }
+      else
+      {
+         solution->volumes[i] = 10;
+         score += max_contribution[i];
+      }
+   }
+   if( old_score != nullptr )
+      *old_score = old_sum;
+   return score;
+}
+
+// Run the selected search method for a fixed amount of time.
+static void RunSearch(const Problem &problem,
+                      const SolveOptions &options,
+                      const CellValues &values,
+                      ProposalSampler *sampler,
+                      TranspositionTable *transpositions,
+                      AssignmentBudget *assignment_budget,
+                      ElitePool *elites,
+                      Solution *solution,
+                      MoveJournal *journal,
+                      std::default_random_engine &rng,
+                      std::chrono::steady_clock::duration duration)
+{
+   if( options.genetic )
+   {
+      Evolve(problem, options, values, kSampleSize, duration, journal, rng,
+             solution);
+   }
+   else if( options.anneal )
+   {
+      Anneal(problem, options, values, kSampleSize, duration, sampler,
+             assignment_budget, journal, rng, solution);
+   }
+   else if( options.tiles > 1 )
+   {
+      TiledSearch(problem, options, kSampleSize, duration, journal, rng,
+                  solution);
+   }
+   else
+   {
+      RandomDance(problem, options, values, sampler, transpositions,
+                  assignment_budget, elites, solution, journal, rng,
+                  duration);
+   }
+}
+
+// Search for placements starting from random positions.  Solution
+// placements and volumes must already be sized for the problem.
+//
+// If 'board' is not null, search is split into epochs of
+// kMigrationInterval.  At the end of each epoch, the island publishes its
+// placements and volumes to the board, and adopts those from the next
+// island in the ring if they are better.  Annealing restarts its cooling
+// schedule at each epoch.
+//
+// 'transpositions' may be null, and is otherwise shared by all islands.
+static void Search(const Problem &problem,
+                   const SolveOptions &options,
+                   const CellValues &values,
+                   TranspositionTable *transpositions,
+                   IslandBoard *board,
+                   int island,
+                   Solution *solution)
+{
+   Grid grid(problem);
+   std::vector<Cell> cells(problem.musicians().size());
+   MoveJournal journal(&grid, &cells, &(solution->placements));
+
+   std::random_device rd;
+   std::default_random_engine rng(rd());
+   SetInitialPositions(
+      problem, values, solution, &journal, rng, kMaxInitIterationSteps);
+   if( options.blockers )
+   {
+      solution->counters[Solution::kBlockersPlaced] += PlaceBlockers(
+         problem, solution->volumes, kSampleSize, &journal);
+   }
+   std::unique_ptr<ProposalSampler> sampler;
+   if( options.value_proposals )
+      sampler.reset(new ProposalSampler(values, grid));
+   AssignmentBudget assignment_budget(kAssignmentShare, problem,
+                                      kSampleSize);
+   ElitePool elites(problem, grid, kEliteCount,
+                    std::max(1, static_cast<int>(
+                       cells.size() * kEliteMinDistance)));
+
+   if( board == nullptr )
+   {
+      RunSearch(problem, options, values, sampler.get(), transpositions,
+                &assignment_budget, &elites, solution, &journal, rng,
+                kRunDuration);
+   }
+   else
+   {
+      std::vector<Cell> migrant;
+      std::vector<double> migrant_volumes;
+      const int source = (island + 1) % board->island_count();
+      const auto end_time = std::chrono::steady_clock::now() + kRunDuration;
+      for(auto now = std::chrono::steady_clock::now();
+          now < end_time;
+          now = std::chrono::steady_clock::now())
+      {
+         const std::chrono::steady_clock::duration epoch =
+            std::min<std::chrono::steady_clock::duration>(
+               end_time - now, kMigrationInterval);
+         RunSearch(problem, options, values, sampler.get(), transpositions,
+                   &assignment_budget, &elites, solution, &journal, rng,
+                   epoch);
+
+         const double score =
+            ComputeLimitedScore(problem, solution->placements,
+                                solution->volumes, kSampleSize);
+         board->Publish(island, score, cells, solution->volumes);
+         if( board->Read(source, &migrant, &migrant_volumes) > score )
+         {
+            journal.Restore(migrant);
+            solution->volumes = migrant_volumes;
+            solution->counters[Solution::kMigrations]++;
+         }
       }
+   }
+
+   if( sampler != nullptr )
+      solution->counters[Solution::kProposalRejections] = sampler->rejections();
+}
+
+// Run independent searches on multiple threads, and keep the best
+// placements and volumes published by any of them.
+static void SolveIslands(const Problem &problem,
+                         const SolveOptions &options,
+                         const CellValues &values,
+                         TranspositionTable *transpositions,
+                         Solution *solution)
+{
+   const int musician_count = static_cast<int>(problem.musicians().size());
+   IslandBoard board(options.islands, musician_count);
+   std::vector<Solution> islands(options.islands, *solution);
+   std::vector<std::thread> threads;
+   threads.reserve(options.islands);
+   for(int i = 0; i < options.islands; i++)
+   {
+      threads.emplace_back([&, i]()
+      {
+         Search(problem, options, values, transpositions, &board, i,
+                &islands[i]);
+      });
+   }
+   for(std::thread &t : threads)
+      t.join();
 
-      solution->volumes[i] = contribution < 0 ? 0 : 10;
+   for(const Solution &island : islands)
+   {
+      for(int i = 0; i < Solution::kCounterCount; i++)
+         solution->counters[i] += island.counters[i];
    }
+
+   // All islands have stopped publishing, so scores are final.
+   const int best_island = board.BestIsland();
+   std::vector<Cell> cells;
+   board.Read(best_island, &cells, &(solution->volumes));
+   const Grid grid(problem);
+   for(int m = 0; m < musician_count; m++)
+      solution->placements[m] = grid.ToXY(cells[m]);
+   fprintf(stderr, "Best placements from island %d of %d\n",
+           best_island, options.islands);
 }
 
 }  // namespace
@@ -519,8 +1193,11 @@ bool BlockedLineOfSight(const Problem &problem,
                         const XY &source,
                         int target_index)
 {
-   return BlockedByAnotherMusician(placements, target_index, source) ||
-          problem.BlockedByPillar(source, placements[target_index]);
+   return PlainScoreCore<double>::BlockedByMusician(
+             placements.data(), static_cast<int>(placements.size()),
+             target_index, source) ||
+          PillarScoreCore<double>::BlockedByPillar(
+             problem.score_tables(), source, placements[target_index]);
 }
 
 double ComputeScore(const Problem &problem,
@@ -533,7 +1210,15 @@ double ComputeScore(const Problem &problem,
                               static_cast<int>(problem.attendees().size()));
 }
 
-void Solve(const Problem &problem, Solution *solution)
+void PrepareProblem(const SolveOptions &options, Problem *problem)
+{
+   if( options.spatial_order )
+      problem->UseSpatialOrder(kSampleSize);
+}
+
+void Solve(const Problem &problem,
+           const SolveOptions &options,
+           Solution *solution)
 {
    solution->counters.fill(0);
    solution->placements.resize(static_cast<int>(problem.musicians().size()));
@@ -541,18 +1226,81 @@ void Solve(const Problem &problem, Solution *solution)
    std::fill(solution->volumes.begin(), solution->volumes.end(), 10);
 
    Grid grid(problem);
+   const CellValues values(problem, grid);
+   if( options.blockers )
+   {
+      solution->counters[Solution::kBlockersMuted] =
+         SelectBlockers(problem, values, grid, &(solution->volumes));
+   }
+   std::unique_ptr<TranspositionTable> transpositions;
+   if( options.transpositions > 0 )
+      transpositions.reset(new TranspositionTable(options.transpositions));
+   if( options.islands > 1 )
+   {
+      SolveIslands(problem, options, values, transpositions.get(), solution);
+   }
+   else
+   {
+      Search(problem, options, values, transpositions.get(), nullptr, 0,
+             solution);
+   }
+   if( transpositions != nullptr )
+   {
+      fprintf(stderr, "Transposition table: %d hits of %d lookups\n",
+              solution->counters[Solution::kTranspositionHits],
+              solution->counters[Solution::kTranspositionLookups]);
+   }
+   if( options.float_scorer )
+   {
+      fprintf(stderr, "Float scorer ranked %d of %d checked candidates "
+              "differently from double scorer\n",
+              solution->counters[Solution::kScorerDisagreements],
+              solution->counters[Solution::kScorerChecks]);
+   }
+   if( options.cascade )
+   {
+      fprintf(stderr, "Cascade: surrogate rejected %d of %d candidates, "
+              "%d of %d audited rejections were false negatives; "
+              "full check rejected %d of %d winners\n",
+              solution->counters[Solution::kSurrogateRejections],
+              solution->counters[Solution::kSurrogateChecks],
+              solution->counters[Solution::kSurrogateFalseNegatives],
+              solution->counters[Solution::kSurrogateAudits],
+              solution->counters[Solution::kFullCheckRejections],
+              solution->counters[Solution::kFullChecks]);
+   }
 
-   std::random_device rd;
-   std::default_random_engine rng(rd());
-   SetInitialPositions(problem, solution, &grid, rng, kMaxInitIterationSteps);
-   RandomDance(problem, solution, &grid, rng);
+   if( options.polish && SanityCheck(problem, *solution) )
+   {
+      // Polish is scored on a sample of attendees, so keep the polished
+      // placements only if they improve the full score.
+      const std::vector<XY> grid_placements = solution->placements;
+      const double grid_score =
+         ComputeScore(problem, solution->placements, solution->volumes);
+      solution->counters[Solution::kPolishSteps] = Polish(
+         problem, kSampleSize,
+         problem.pillars().empty() ? kPolishDuration : kPillarPolishDuration,
+         solution);
+      solution->score = SanityCheck(problem, *solution)
+         ? ComputeScore(problem, solution->placements, solution->volumes)
+         : kErrorScore;
+      fprintf(stderr, "Polish: %.0f -> %.0f\n", grid_score, solution->score);
+      if( solution->score < grid_score )
+      {
+         solution->placements = grid_placements;
+         solution->score = grid_score;
+      }
+      return;
+   }
 
    solution->score = SanityCheck(problem, *solution)
       ? ComputeScore(problem, solution->placements, solution->volumes)
       : kErrorScore;
 }
 
-bool UpgradeSolution(const Problem &problem, Solution *solution)
+bool UpgradeSolution(const Problem &problem,
+                     const SolveOptions &options,
+                     Solution *solution)
 {
    solution->counters.fill(0);
    solution->score = kErrorScore;
@@ -572,11 +1320,14 @@ bool UpgradeSolution(const Problem &problem, Solution *solution)
       fputs("Solution does not pass sanity check\n", stderr);
       return false;
    }
-   const double old_score =
-      ComputeScore(problem, solution->placements, solution->volumes);
-   AdjustVolumes(problem, solution);
-   solution->score =
-      ComputeScore(problem, solution->placements, solution->volumes);
+   double old_score;
+   solution->score = AdjustVolumes(problem, solution, &old_score);
+   if( options.relocate )
+   {
+      solution->counters[Solution::kRelocations] =
+         RelocateToLocalOptimum(problem, kRunDuration, solution);
+      solution->score = AdjustVolumes(problem, solution, nullptr);
+   }
 
    fprintf(stderr, "%.0f -> %.0f, change = %+.0f\n",
            old_score, solution->score, solution->score - old_score);
@@ -22,12 +22,129 @@ struct Solution
       kDanceIterations,
       kDanceMovements,
       kDanceResets,
+      kScorerChecks,
+      kScorerDisagreements,
+      kDanceProposals,
+      kProposalRejections,
+      kAnnealMoves,
+      kAnnealAccepted,
+      kMigrations,
+      kCrossovers,
+      kCrossoverAccepted,
+      kCrossoverRepairs,
+      kReassignments,
+      kReassignmentsKept,
+      kBlockersMuted,
+      kBlockersPlaced,
+      kMuteToggles,
+      kMuteAccepted,
+      kPolishSteps,
+      kRelocations,
+      kRandomPartitions,
+      kRandomPartitionsAccepted,
+      kSpatialPartitions,
+      kSpatialPartitionsAccepted,
+      kInstrumentPartitions,
+      kInstrumentPartitionsAccepted,
+      kAttendeePartitions,
+      kAttendeePartitionsAccepted,
+      kTileMoves,
+      kTileConflicts,
+      kSurrogateChecks,
+      kSurrogateRejections,
+      kSurrogateAudits,
+      kSurrogateFalseNegatives,
+      kFullChecks,
+      kFullCheckRejections,
+      kTranspositionLookups,
+      kTranspositionHits,
 
       kCounterCount
    };
    std::array<int, kCounterCount> counters;
 };
 
+// Solver settings, set from command line flags.
+struct SolveOptions
+{
+   // Sort attendees and musician iteration order along a Hilbert curve.
+   bool spatial_order = false;
+
+   // Rank search candidates with single precision scores.
+   bool float_scorer = false;
+
+   // Screen random dance candidates with a blocking-free surrogate score
+   // before scoring them with blocking, and check winners against all
+   // attendees before accepting them.  Candidates are rejected if their
+   // surrogate score is lower than that of the current placements by
+   // more than cascade_tolerance times its magnitude.
+   bool cascade = false;
+   double cascade_tolerance = 0.01;
+
+   // Draw destination cells in proportion to precomputed cell values.
+   bool value_proposals = false;
+
+   // Search with simulated annealing instead of random dance.
+   bool anneal = false;
+
+   // Annealing schedule.  Initial temperature is set such that an average
+   // worsening move is accepted with probability anneal_acceptance, and
+   // decreases geometrically to anneal_final_ratio times the initial
+   // temperature over anneal_levels steps.
+   double anneal_acceptance = 0.5;
+   double anneal_final_ratio = 1e-3;
+   int anneal_levels = 20;
+
+   // Number of search threads.  If more than one, each thread runs an
+   // independent search, exchanging best placements periodically.
+   // Searches run in epochs between exchanges, and annealing restarts
+   // its cooling schedule at each epoch rather than cooling once over
+   // the whole run.
+   int islands = 1;
+
+   // Number of stage tiles.  If more than one, each search thread splits
+   // into one thread per tile, reconciling moves periodically.
+   int tiles = 1;
+
+   // Number of slots in the table of random dance scores keyed by
+   // placement hash, shared by all islands.  Zero disables the table.
+   int transpositions = 0;
+
+   // Search by recombining a population of placements.
+   bool genetic = false;
+
+   // Placements from earlier solutions, used to seed genetic search.
+   std::vector<std::vector<XY>> seeds;
+
+   // Periodically reassign instruments to occupied cells optimally.
+   bool assignment = false;
+
+   // Mute musicians that can't contribute positive score, and place them
+   // to block sightlines to attendees who dislike other musicians.
+   bool blockers = false;
+
+   // Toggle musician volumes between zero and full as annealing moves.
+   bool mute_moves = false;
+
+   // Refine placements off the grid after search.
+   bool polish = false;
+
+   // When upgrading a solution, relocate musicians to a local optimum.
+   bool relocate = false;
+
+   // How random dance divides movable musicians into groups.  Mixed
+   // partition picks one of the other strategies at each iteration.
+   enum Partition
+   {
+      kRandomPartition,
+      kSpatialPartition,
+      kInstrumentPartition,
+      kAttendeePartition,
+      kMixedPartition
+   };
+   Partition partition = kRandomPartition;
+};
+
 // Check if path between attendee and musician is blocked.
 bool BlockedLineOfSight(const Problem &problem,
                         const std::vector<XY> &placements,
@@ -39,10 +156,17 @@ double ComputeScore(const Problem &problem,
                     const std::vector<XY> &placements,
                     const std::vector<double> &volumes);
 
+// Apply option-dependent changes to problem before solving.
+void PrepareProblem(const SolveOptions &options, Problem *problem);
+
 // Generate solution.
-void Solve(const Problem &problem, Solution *solution);
+void Solve(const Problem &problem,
+           const SolveOptions &options,
+           Solution *solution);
 
 // Upgrade a solution.  Returns false if upgrade failed.
-bool UpgradeSolution(const Problem &problem, Solution *solution);
+bool UpgradeSolution(const Problem &problem,
+                     const SolveOptions &options,
+                     Solution *solution);
 
 #endif  // SOLUTION_H_
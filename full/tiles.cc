@@ -0,0 +1,327 @@
+#include"tiles.h"
+
+#include<stdio.h>
+
+#include<algorithm>
+#include<cmath>
+#include<limits>
+#include<thread>
+#include<vector>
+
+#include"delta_score.h"
+#include"grid.h"
+
+namespace {
+
+// Width of the halo band along edges shared with other tiles, in cells.
+static constexpr int kHaloCells = 2;
+
+// Time between reconciliations.
+static constexpr std::chrono::milliseconds kEpochDuration{500};
+
+// Probability of proposing a swap within the tile instead of a move.
+static constexpr double kSwapProbability = 0.3;
+
+// Division of grid cells into rectangular tiles.
+class Tiling
+{
+public:
+   Tiling(const Grid &grid, int tile_count)
+      : columns_(grid.columns()), rows_(grid.rows()), shifted_(false)
+   {
+      // Among factorizations of tile_count that fit the grid, pick the
+      // one where tiles are closest to square.  If none fit, fall back
+      // to one tile per grid column or row.
+      tile_columns_ = std::min(tile_count, columns_);
+      tile_rows_ = std::max(1, std::min(rows_, tile_count / tile_columns_));
+      double best_skew = std::numeric_limits<double>::infinity();
+      for(int c = 1; c <= std::min(tile_count, columns_); c++)
+      {
+         const int r = tile_count / c;
+         if( r * c != tile_count || r > rows_ )
+            continue;
+         const double tile_aspect = (static_cast<double>(columns_) / c) /
+                                    (static_cast<double>(rows_) / r);
+         const double skew = std::fabs(std::log(tile_aspect));
+         if( skew < best_skew )
+         {
+            best_skew = skew;
+            tile_columns_ = c;
+            tile_rows_ = r;
+         }
+      }
+   }
+
+   int count() const { return tile_columns_ * tile_rows_; }
+
+   // Move edges between tiles by about half a tile right and down, so
+   // that musicians near an edge in one epoch are in a tile interior in
+   // the next.  Outer edges stay on the stage edges.
+   void set_shifted(bool shifted) { shifted_ = shifted; }
+
+   int TileOf(const Cell &c) const
+   {
+      return Index(c.row, rows_, tile_rows_) * tile_columns_ +
+             Index(c.column, columns_, tile_columns_);
+   }
+
+   // Range of cells in a tile, as [begin, end).
+   int ColumnBegin(int tile) const
+   {
+      return Begin(tile % tile_columns_, columns_, tile_columns_);
+   }
+   int ColumnEnd(int tile) const
+   {
+      return Begin(tile % tile_columns_ + 1, columns_, tile_columns_);
+   }
+   int RowBegin(int tile) const
+   {
+      return Begin(tile / tile_columns_, rows_, tile_rows_);
+   }
+   int RowEnd(int tile) const
+   {
+      return Begin(tile / tile_columns_ + 1, rows_, tile_rows_);
+   }
+
+   // Check if cell is outside the halo of its tile.  Stage edges are not
+   // shared with other tiles, so they have no halo.
+   bool Interior(const Cell &c) const
+   {
+      const int tile = TileOf(c);
+      return (ColumnBegin(tile) == 0 ||
+              c.column - ColumnBegin(tile) >= kHaloCells) &&
+             (ColumnEnd(tile) == columns_ ||
+              ColumnEnd(tile) - c.column > kHaloCells) &&
+             (RowBegin(tile) == 0 ||
+              c.row - RowBegin(tile) >= kHaloCells) &&
+             (RowEnd(tile) == rows_ ||
+              RowEnd(tile) - c.row > kHaloCells);
+   }
+
+private:
+   // Offset of inner tile edges along an axis of 'size' cells.
+   int Shift(int size, int tiles) const
+   {
+      return shifted_ ? size / (2 * tiles) : 0;
+   }
+
+   // Index of tile containing cell 'c' along an axis of 'size' cells.
+   int Index(int c, int size, int tiles) const
+   {
+      const int shifted = c - Shift(size, tiles);
+      return shifted < 0 ? 0 : shifted * tiles / size;
+   }
+
+   // First cell of tile 'index' out of 'tiles' along an axis of 'size'
+   // cells, matching Index.
+   int Begin(int index, int size, int tiles) const
+   {
+      if( index == 0 || index == tiles )
+         return index == 0 ? 0 : size;
+      return (index * size + tiles - 1) / tiles + Shift(size, tiles);
+   }
+
+   int columns_, rows_;
+   int tile_columns_, tile_rows_;
+   bool shifted_;
+};
+
+// Hill-climb musicians of a single tile on private copies of the shared
+// state until 'end_time', and append accepted moves to 'accepted'.
+static void SearchTile(const Problem &problem,
+                       const Tiling &tiling,
+                       int tile,
+                       const std::vector<int> &members,
+                       const MoveJournal &shared,
+                       const DeltaScorer &shared_scorer,
+                       std::chrono::steady_clock::time_point end_time,
+                       unsigned int seed,
+                       std::vector<MoveJournal::Entry> *accepted)
+{
+   Grid grid(problem);
+   std::vector<Cell> cells(shared.cells());
+   std::vector<XY> placements(shared.placements());
+   MoveJournal journal(&grid, &cells, &placements);
+   for(int m = 0; m < static_cast<int>(cells.size()); m++)
+      journal.Place(m, cells[m]);
+   DeltaScorer scorer(shared_scorer);
+
+   std::default_random_engine rng(seed);
+   std::uniform_int_distribution<> member_select(
+      0, static_cast<int>(members.size()) - 1);
+   std::uniform_int_distribution<> column_select(
+      tiling.ColumnBegin(tile), tiling.ColumnEnd(tile) - 1);
+   std::uniform_int_distribution<> row_select(
+      tiling.RowBegin(tile), tiling.RowEnd(tile) - 1);
+   std::bernoulli_distribution swap_select(kSwapProbability);
+   while( std::chrono::steady_clock::now() < end_time )
+   {
+      const int m = members[member_select(rng)];
+      if( swap_select(rng) )
+      {
+         const int other = members[member_select(rng)];
+         if( problem.musicians()[m] == problem.musicians()[other] )
+            continue;
+         journal.Swap(m, other);
+      }
+      else
+      {
+         const Cell target = Grid::MakeCell(column_select(rng),
+                                            row_select(rng));
+         if( grid.Get(target) != 0 )
+            continue;
+         journal.Move(m, target);
+      }
+
+      const double old_score = scorer.score();
+      scorer.Apply(journal.entries(), grid);
+      if( scorer.score() > old_score )
+      {
+         accepted->insert(accepted->end(), journal.entries().begin(),
+                          journal.entries().end());
+         journal.Commit();
+      }
+      else
+      {
+         scorer.Undo(journal.entries(), grid);
+         journal.Rollback();
+      }
+   }
+}
+
+// Apply entries to shared state and keep them if they improve score
+// together.  Entries that no longer match shared state, because an
+// earlier move from the same tile was dropped, are skipped.  Returns
+// number of entries kept.
+static int ApplyIfImproving(const std::vector<MoveJournal::Entry> &entries,
+                            MoveJournal *journal,
+                            DeltaScorer *scorer)
+{
+   const Grid &grid = *journal->grid();
+   for(const MoveJournal::Entry &e : entries)
+   {
+      if( journal->cells()[e.musician] != e.from )
+         continue;
+      if( e.other >= 0 )
+      {
+         if( journal->cells()[e.other] == e.to )
+            journal->Swap(e.musician, e.other);
+      }
+      else if( grid.Get(e.to) == 0 )
+      {
+         journal->Move(e.musician, e.to);
+      }
+   }
+   if( journal->entries().empty() )
+      return 0;
+
+   const double old_score = scorer->score();
+   scorer->Apply(journal->entries(), grid);
+   if( scorer->score() > old_score )
+   {
+      const int kept = static_cast<int>(journal->entries().size());
+      journal->Commit();
+      return kept;
+   }
+   scorer->Undo(journal->entries(), grid);
+   journal->Rollback();
+   return 0;
+}
+
+// Merge moves accepted by a tile into shared state.  Returns number of
+// moves kept.
+static int Reconcile(const Tiling &tiling,
+                     const std::vector<MoveJournal::Entry> &accepted,
+                     MoveJournal *journal,
+                     DeltaScorer *scorer)
+{
+   std::vector<MoveJournal::Entry> interior, halo;
+   for(const MoveJournal::Entry &e : accepted)
+   {
+      if( tiling.Interior(e.from) && tiling.Interior(e.to) )
+         interior.push_back(e);
+      else
+         halo.push_back(e);
+   }
+
+   // If interior moves conflict as a batch, retry them one at a time
+   // along with halo moves.
+   int kept = ApplyIfImproving(interior, journal, scorer);
+   if( kept == 0 )
+      halo.insert(halo.begin(), interior.begin(), interior.end());
+   std::vector<MoveJournal::Entry> single(1);
+   for(const MoveJournal::Entry &e : halo)
+   {
+      single[0] = e;
+      kept += ApplyIfImproving(single, journal, scorer);
+   }
+   return kept;
+}
+
+}  // namespace
+
+void TiledSearch(const Problem &problem,
+                 const SolveOptions &options,
+                 int attendee_count,
+                 std::chrono::steady_clock::duration duration,
+                 MoveJournal *journal,
+                 std::default_random_engine &rng,
+                 Solution *solution)
+{
+   const auto end_time = std::chrono::steady_clock::now() + duration;
+   const int musician_count = static_cast<int>(problem.musicians().size());
+   const Grid &grid = *journal->grid();
+   Tiling tiling(grid, options.tiles);
+   if( tiling.count() != options.tiles )
+   {
+      fprintf(stderr, "Warning: %d tiles do not fit %dx%d grid, using %d\n",
+              options.tiles, grid.columns(), grid.rows(), tiling.count());
+   }
+   DeltaScorer scorer(problem, journal->placements(), solution->volumes,
+                      attendee_count);
+
+   std::vector<std::vector<int>> members(tiling.count());
+   std::vector<std::vector<MoveJournal::Entry>> accepted(tiling.count());
+   int epochs = 0, proposed = 0, kept = 0;
+   for(auto now = std::chrono::steady_clock::now();
+       now < end_time;
+       now = std::chrono::steady_clock::now(), epochs++)
+   {
+      const auto epoch_end = std::min<std::chrono::steady_clock::time_point>(
+         end_time, now + kEpochDuration);
+      tiling.set_shifted(epochs % 2 == 1);
+      for(std::vector<int> &tile_members : members)
+         tile_members.clear();
+      for(int m = 0; m < musician_count; m++)
+         members[tiling.TileOf(journal->cells()[m])].push_back(m);
+
+      std::vector<std::thread> threads;
+      threads.reserve(tiling.count());
+      for(int tile = 0; tile < tiling.count(); tile++)
+      {
+         accepted[tile].clear();
+         if( members[tile].empty() )
+            continue;
+         const unsigned int seed = rng();
+         threads.emplace_back([&, tile, seed]()
+         {
+            SearchTile(problem, tiling, tile, members[tile], *journal, scorer,
+                       epoch_end, seed, &accepted[tile]);
+         });
+      }
+      for(std::thread &t : threads)
+         t.join();
+
+      for(int tile = 0; tile < tiling.count(); tile++)
+      {
+         proposed += static_cast<int>(accepted[tile].size());
+         kept += Reconcile(tiling, accepted[tile], journal, &scorer);
+      }
+   }
+
+   solution->counters[Solution::kTileMoves] += proposed;
+   solution->counters[Solution::kTileConflicts] += proposed - kept;
+   fprintf(stderr, "Tiled search: %d tiles, %d epochs, kept %d of %d moves, "
+           "score = %.0f\n",
+           tiling.count(), epochs, kept, proposed, scorer.score());
+}
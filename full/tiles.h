@@ -0,0 +1,47 @@
+#ifndef TILES_H_
+#define TILES_H_
+
+#include<chrono>
+#include<random>
+#include"move_journal.h"
+#include"problem.h"
+#include"solution.h"
+
+// Improve placements by splitting the stage into tiles that are searched
+// in parallel.
+//
+// Grid cells are divided into options.tiles rectangular tiles, arranged in
+// the rows and columns that make tiles closest to square.  If the grid
+// cannot be split that way, fewer tiles are used with a warning.  Search
+// runs in epochs, and edges between tiles move by about half a tile on
+// alternate epochs so that musicians can cross them.  At the start of each
+// epoch, musicians belong to the tile containing their cell, and one
+// thread per tile hill-climbs its own musicians with moves to free cells
+// in the same tile and swaps within the tile.  Each thread scores moves on
+// its own copy of a shared DeltaScorer over the first 'attendee_count'
+// attendees, so it only sees moves made by other tiles at epoch
+// boundaries.  The copy holds blocker counts for every musician and
+// attendee, so each epoch costs one O(musicians * attendees) copy per
+// tile, about the same as scoring a single move.
+//
+// Since tiles own disjoint cells, moves never collide on cells, but they
+// may still interact through blocking and closeness.  Accepted moves are
+// reconciled optimistically at the end of each epoch: moves within the
+// interior of a tile are applied to the shared state as one batch per
+// tile, and kept if the batch still improves the shared score.  Moves
+// that touch the halo, cells within kHaloCells of a tile edge, are more
+// likely to interact with neighbouring tiles, so they are applied one at
+// a time and dropped if they no longer improve.  Counters record moves
+// accepted by tiles and moves dropped at reconciliation.
+//
+// 'journal' must be in committed state on entry, and holds the
+// reconciled placements on return.
+void TiledSearch(const Problem &problem,
+                 const SolveOptions &options,
+                 int attendee_count,
+                 std::chrono::steady_clock::duration duration,
+                 MoveJournal *journal,
+                 std::default_random_engine &rng,
+                 Solution *solution);
+
+#endif  // TILES_H_
@@ -0,0 +1,49 @@
+#include"transposition.h"
+
+#include<string.h>
+
+namespace {
+
+static uint64_t ToBits(double score)
+{
+   uint64_t bits;
+   memcpy(&bits, &score, sizeof(bits));
+   return bits;
+}
+
+static double FromBits(uint64_t bits)
+{
+   double score;
+   memcpy(&score, &bits, sizeof(score));
+   return score;
+}
+
+}  // namespace
+
+TranspositionTable::TranspositionTable(int size)
+{
+   uint64_t slot_count = 1;
+   while( slot_count < static_cast<uint64_t>(size) )
+      slot_count <<= 1;
+   mask_ = slot_count - 1;
+   slots_.reset(new Slot[slot_count]);
+}
+
+bool TranspositionTable::Lookup(uint64_t hash, double *score) const
+{
+   const Slot &slot = slots_[hash & mask_];
+   const uint64_t data = slot.data.load(std::memory_order_relaxed);
+   const uint64_t check = slot.check.load(std::memory_order_relaxed);
+   if( (check ^ data) != hash )
+      return false;
+   *score = FromBits(data);
+   return true;
+}
+
+void TranspositionTable::Insert(uint64_t hash, double score)
+{
+   Slot &slot = slots_[hash & mask_];
+   const uint64_t data = ToBits(score);
+   slot.data.store(data, std::memory_order_relaxed);
+   slot.check.store(hash ^ data, std::memory_order_relaxed);
+}
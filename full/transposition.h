@@ -0,0 +1,43 @@
+#ifndef TRANSPOSITION_H_
+#define TRANSPOSITION_H_
+
+#include<stdint.h>
+
+#include<atomic>
+#include<memory>
+
+// Bounded lock-free cache of search scores, keyed by placement hash.
+//
+// Slots are indexed by low bits of the hash, and new entries always
+// replace old ones, so memory stays fixed however long search runs.
+// Each slot holds score bits and hash XOR score bits as two relaxed
+// atomics.  A reader that sees a torn write from another thread fails
+// the hash check and treats the slot as a miss, so no locks are needed
+// when the table is shared between islands.
+//
+// Scores are only comparable if all writers use the same scorer and
+// volumes.
+class TranspositionTable
+{
+public:
+   // Number of slots is rounded up to a power of two.
+   explicit TranspositionTable(int size);
+
+   // Look up score for a hash.  Returns true on hit.
+   bool Lookup(uint64_t hash, double *score) const;
+
+   // Store score for a hash, replacing whatever was in its slot.
+   void Insert(uint64_t hash, double score);
+
+private:
+   struct Slot
+   {
+      std::atomic<uint64_t> check{0};
+      std::atomic<uint64_t> data{0};
+   };
+
+   uint64_t mask_;
+   std::unique_ptr<Slot[]> slots_;
+};
+
+#endif  // TRANSPOSITION_H_
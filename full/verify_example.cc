@@ -1,9 +1,21 @@
 #include<stdio.h>
+
+#include<cmath>
+#include<random>
+#include<string>
+#include<vector>
+
+#include"delta_score.h"
+#include"grid.h"
+#include"move_journal.h"
 #include"problem.h"
 #include"solution.h"
 
 static constexpr double kExpectedScore = 3270;
 
+// Number of random steps for each incremental scoring check.
+static constexpr int kRandomSteps = 300;
+
 static constexpr char kProblem[] = R"(
 {
     "room_width": 2000.0,
@@ -31,6 +43,243 @@ static constexpr char kProblem[] = R"(
 }
 )";
 
+// Generate a problem with random musicians and attendees in front of
+// the stage, close enough for plenty of blocking.
+static std::string RandomProblem(std::default_random_engine &rng,
+                                 int pillar_count)
+{
+   static constexpr int kMusicians = 30;
+   static constexpr int kInstruments = 3;
+   static constexpr int kAttendees = 40;
+   std::uniform_real_distribution<> taste(-1000, 1000);
+   std::uniform_real_distribution<> x(0, 400), y(160, 400);
+   std::uniform_real_distribution<> radius(2, 10);
+   std::uniform_int_distribution<> instrument(0, kInstruments - 1);
+
+   std::string text =
+      "{\"room_width\": 400, \"room_height\": 400, "
+      "\"stage_width\": 160, \"stage_height\": 120, "
+      "\"stage_bottom_left\": [120, 20], \"musicians\": [";
+   for(int m = 0; m < kMusicians; m++)
+   {
+      // First few musicians cover every instrument.
+      text += (m ? ", " : "") +
+              std::to_string(m < kInstruments ? m : instrument(rng));
+   }
+   text += "], \"attendees\": [";
+   for(int j = 0; j < kAttendees; j++)
+   {
+      text += (j ? ", " : "") + std::string("{\"x\": ") +
+              std::to_string(x(rng)) + ", \"y\": " + std::to_string(y(rng)) +
+              ", \"tastes\": [";
+      for(int i = 0; i < kInstruments; i++)
+         text += (i ? ", " : "") + std::to_string(taste(rng));
+      text += "]}";
+   }
+   text += "], \"pillars\": [";
+   for(int i = 0; i < pillar_count; i++)
+   {
+      text += (i ? ", " : "") + std::string("{\"center\": [") +
+              std::to_string(x(rng)) + ", " + std::to_string(y(rng)) +
+              "], \"radius\": " + std::to_string(radius(rng)) + "}";
+   }
+   return text + "]}";
+}
+
+// Random grid state for a problem, with placements matching cells.
+struct RandomState
+{
+   RandomState(const Problem &problem, std::default_random_engine &rng)
+      : grid(problem),
+        cells(problem.musicians().size()),
+        placements(problem.musicians().size()),
+        volumes(problem.musicians().size(), 1)
+   {
+      std::uniform_int_distribution<> column(0, grid.columns() - 1);
+      std::uniform_int_distribution<> row(0, grid.rows() - 1);
+      for(int m = 0; m < static_cast<int>(cells.size()); m++)
+      {
+         do
+         {
+            cells[m] = Grid::MakeCell(column(rng), row(rng));
+         } while( grid.Get(cells[m]) != 0 );
+         grid.Set(cells[m], 1);
+         placements[m] = grid.ToXY(cells[m]);
+      }
+   }
+
+   // Free cell chosen without the grid's own random device.
+   Cell FreeCell(std::default_random_engine &rng) const
+   {
+      std::uniform_int_distribution<> select(0, grid.free_count() - 1);
+      int index = select(rng);
+      for(int c = 0;; c++)
+      {
+         if( grid.Get(grid.FromIndex(c)) == 0 && index-- == 0 )
+            return grid.FromIndex(c);
+      }
+   }
+
+   Grid grid;
+   std::vector<Cell> cells;
+   std::vector<XY> placements;
+   std::vector<double> volumes;
+};
+
+// Apply random moves, swaps, and volume changes to DeltaScorer, keeping
+// or undoing each one, and check that its score matches ComputeScore.
+// Returns number of mismatches.
+static int CheckDeltaScorer(const Problem &problem,
+                            std::default_random_engine &rng)
+{
+   RandomState state(problem, rng);
+   MoveJournal journal(&state.grid, &state.cells, &state.placements);
+   const int musician_count = static_cast<int>(state.cells.size());
+   DeltaScorer scorer(problem, state.placements, state.volumes,
+                      static_cast<int>(problem.attendees().size()));
+   std::uniform_int_distribution<> musician(0, musician_count - 1);
+   std::uniform_int_distribution<> action(0, 3);
+   std::uniform_real_distribution<> volume(0, 10);
+
+   int mismatches = 0;
+   for(int step = 0; step < kRandomSteps; step++)
+   {
+      const int m = musician(rng);
+      switch( action(rng) )
+      {
+         case 0:
+            state.volumes[m] = step % 5 == 0 ? 0 : volume(rng);
+            scorer.SetVolume(m, state.volumes[m]);
+            break;
+         case 1:
+            journal.Swap(m, (m + 1 + musician(rng) % (musician_count - 1)) %
+                            musician_count);
+            scorer.Apply(journal.entries(), state.grid);
+            break;
+         default:
+            journal.Move(m, state.FreeCell(rng));
+            journal.Move(musician(rng), state.FreeCell(rng));
+            scorer.Apply(journal.entries(), state.grid);
+            break;
+      }
+      if( step % 2 == 0 )
+      {
+         scorer.Undo(journal.entries(), state.grid);
+         journal.Rollback();
+      }
+      journal.Commit();
+      if( scorer.score() !=
+          ComputeScore(problem, state.placements, state.volumes) )
+      {
+         mismatches++;
+      }
+   }
+   return mismatches;
+}
+
+// Compare MoveValues against moving a copy of the scorer to each cell.
+// Without closeness, deltas must be exact.  With closeness, each other
+// musician of the same instrument may be off by one per attendee.
+// Returns number of cells outside the bound.
+static int CheckMoveValues(const Problem &problem,
+                           std::default_random_engine &rng)
+{
+   RandomState state(problem, rng);
+   const int attendee_count = static_cast<int>(problem.attendees().size());
+   const DeltaScorer scorer(problem, state.placements, state.volumes,
+                            attendee_count);
+   const int musician_count = static_cast<int>(state.cells.size());
+   const int cell_count = state.grid.columns() * state.grid.rows();
+
+   int mismatches = 0;
+   std::vector<double> deltas;
+   for(int m = 0; m < musician_count; m += 7)
+   {
+      double bound = 0;
+      if( problem.UseClosenessExtension() )
+      {
+         for(int k = 0; k < musician_count; k++)
+         {
+            if( k != m && problem.musicians()[k] == problem.musicians()[m] )
+               bound += attendee_count;
+         }
+      }
+
+      scorer.MoveValues(m, state.grid, &deltas);
+      for(int c = 0; c < cell_count; c++)
+      {
+         const Cell cell = state.grid.FromIndex(c);
+         bool available = true;
+         for(int k = 0; k < musician_count; k++)
+         {
+            if( k != m && state.cells[k] == cell )
+               available = false;
+         }
+         if( !available )
+         {
+            mismatches += deltas[c] != -INFINITY;
+            continue;
+         }
+         DeltaScorer moved(scorer);
+         moved.Move(m, state.grid.ToXY(cell));
+         if( std::fabs(moved.score() - scorer.score() - deltas[c]) > bound )
+            mismatches++;
+      }
+   }
+   return mismatches;
+}
+
+// Check that Rollback, Replay, and Restore return to the same cells,
+// placements, and hash.  Returns number of mismatches.
+static int CheckMoveJournal(const Problem &problem,
+                            std::default_random_engine &rng)
+{
+   RandomState state(problem, rng);
+   MoveJournal journal(&state.grid, &state.cells, &state.placements);
+   const int musician_count = static_cast<int>(state.cells.size());
+   std::uniform_int_distribution<> musician(0, musician_count - 1);
+
+   int mismatches = 0;
+   const auto expect = [&](const std::vector<Cell> &cells, uint64_t hash)
+   {
+      bool match = state.cells == cells && journal.hash() == hash;
+      for(int m = 0; m < musician_count; m++)
+      {
+         const XY p = state.grid.ToXY(cells[m]);
+         match = match && state.grid.Get(cells[m]) != 0 &&
+                 state.placements[m].x == p.x && state.placements[m].y == p.y;
+      }
+      mismatches += !match;
+   };
+   for(int step = 0; step < kRandomSteps; step++)
+   {
+      const std::vector<Cell> before = state.cells;
+      const uint64_t before_hash = journal.hash();
+      for(int i = step % 4; i >= 0; i--)
+      {
+         const int m = musician(rng);
+         if( i % 2 == 0 )
+            journal.Move(m, state.FreeCell(rng));
+         else
+            journal.Swap(m, (m + 1) % musician_count);
+      }
+      const std::vector<MoveJournal::Entry> entries = journal.entries();
+      const std::vector<Cell> after = state.cells;
+      const uint64_t after_hash = journal.hash();
+
+      journal.Rollback();
+      expect(before, before_hash);
+      journal.Replay(entries);
+      expect(after, after_hash);
+      journal.Commit();
+      journal.Restore(before);
+      expect(before, before_hash);
+      journal.Restore(after);
+      expect(after, after_hash);
+   }
+   return mismatches;
+}
+
 int main(int argc, char **argv)
 {
    const Problem problem(kProblem);
@@ -50,5 +299,21 @@ int main(int argc, char **argv)
       ComputeScore(problem, solution.placements, solution.volumes);
 
    printf("Expected %g, actual = %g\n", kExpectedScore, solution.score);
-   return 0;
+
+   // Incremental scorers and journal, on problems with and without
+   // pillars, i.e. with and without closeness extension.
+   std::default_random_engine rng(1);
+   int failures = 0;
+   for(int pillars : {0, 3})
+   {
+      const Problem random_problem(RandomProblem(rng, pillars));
+      const int delta = CheckDeltaScorer(random_problem, rng);
+      const int move_values = CheckMoveValues(random_problem, rng);
+      const int journal = CheckMoveJournal(random_problem, rng);
+      printf("Pillars = %d: DeltaScorer mismatches = %d, "
+             "MoveValues mismatches = %d, MoveJournal mismatches = %d\n",
+             pillars, delta, move_values, journal);
+      failures += delta + move_values + journal;
+   }
+   return failures == 0 ? 0 : 1;
 }
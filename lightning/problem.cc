@@ -152,6 +152,9 @@ Problem::Problem(const std::string &json_text)
    };
    std::sort(attendees_.begin(), attendees_.end(), SortByInfluenceRange());
 
+   score_tables_.SetAttendees(attendees_,
+                              static_cast<int>(instruments_.size()));
+
    #ifdef BENCHMARK
       const std::chrono::duration<double> elapsed =
          std::chrono::steady_clock::now() - start_time;
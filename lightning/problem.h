@@ -4,10 +4,9 @@
 #include<string>
 #include<vector>
 
-struct XY
-{
-   double x, y;
-};
+#include"../full/score_core.h"
+
+using XY = ScorePoint<double>;
 
 class Problem
 {
@@ -31,6 +30,7 @@ public:
    const std::vector<int> &instruments() const { return instruments_; }
    const std::vector<int> &musicians() const { return musicians_; }
    const std::vector<Attendee> &attendees() const { return attendees_; }
+   const ScoreTables<double> &score_tables() const { return score_tables_; }
 
 private:
    // Compute maximum influence for each attendee.
@@ -50,6 +50,9 @@ private:
    // Attendee preferences, sorted by attendees who are most sensitive to
    // placement changes first.
    std::vector<Attendee> attendees_;
+
+   // Copy of attendees for the scoring core.
+   ScoreTables<double> score_tables_;
 };
 
 #endif  // PROBLEM_H_
@@ -23,9 +23,6 @@ static constexpr int kRandomMoveLimit = 64;
 // Minimum radius from musician to edge or another musician.
 static constexpr double kMargin = 10;
 
-// Minimum radius for blocking.
-static constexpr double kBlockingRadius = 5;
-
 // Return this score in event of error.
 static constexpr double kErrorScore = -1e9;
 
@@ -36,66 +33,6 @@ static double DistanceSquared(const XY &a, const XY &b)
    return dx * dx + dy * dy;
 }
 
-// Check if potentially blocking musician 'b' is within bounding box
-// enclosed by 'u' and 'v'.
-//
-// This check is applied before testing IsBlocked below.  This is because
-// IsBlocked measures distance to an infinite line, but we just want
-// distance to a specific segment.
-//
-// This is not completely accurate in that a point could be within
-// that corner of the rectangle that is 2*sqrt(5**2 + 5**2) away and
-// still fall on the same line, but contest spec says musicians can
-// not be placed within radius 10 of each other, and 10 is greater
-// than that corner distance, so we should be fine.
-//
-// That said, the scores we computed seem to differ from contest
-// output by few parts per million, always in the negative direction
-// (our score is less than what the contest environment computed).  I
-// can't tell if this is just floating point precision or not.  Getting
-// them to match exactly doesn't seem to be worth the effort.
-static bool IsWithinBoundingBox(const XY &u, const XY &v, const XY &b)
-{
-   return b.x >= std::min(u.x, v.x) - kBlockingRadius &&
-          b.x <= std::max(u.x, v.x) + kBlockingRadius &&
-          b.y >= std::min(u.y, v.y) - kBlockingRadius &&
-          b.y <= std::max(u.y, v.y) + kBlockingRadius;
-}
-
-// Check musician 'b' blocks 'a' with respect to audience 'p'.
-static bool IsBlocked(const XY &p, const XY &a, const XY &b)
-{
-   #if 0
-      const double dx = a.x - p.x;
-      const double dy = a.y - p.y;
-      const double n = fabs(dx * (p.y - b.y) - dy * (p.x - b.x));
-      return n / hypot(dx, dy) <= kBlockingRadius;
-   #else
-      const double dx = a.x - p.x;
-      const double dy = a.y - p.y;
-      const double n = dx * (p.y - b.y) - dy * (p.x - b.x);
-      return n * n <= kBlockingRadius * kBlockingRadius * (dx * dx + dy * dy);
-   #endif
-}
-
-// Check if any musician blocks 'a' with respect to audience 'p'.
-static bool IsAnyBlocking(const std::vector<XY> &placements,
-                          int a,
-                          const XY &p)
-{
-   for(int b = 0; b < static_cast<int>(placements.size()); b++)
-   {
-      if( b == a )
-         continue;
-      if( IsWithinBoundingBox(p, placements[a], placements[b]) &&
-          IsBlocked(p, placements[a], placements[b]) )
-      {
-         return true;
-      }
-   }
-   return false;
-}
-
 static double ComputeLimitedScore(const Problem &problem,
                                   const std::vector<XY> &placements,
                                   int attendee_count)
@@ -106,7 +43,6 @@ static double ComputeLimitedScore(const Problem &problem,
 
    const int limit = std::min(attendee_count,
                               static_cast<int>(problem.attendees().size()));
-   double score = 0;
 
    const XY stage_min =
    {
@@ -128,24 +64,26 @@ static double ComputeLimitedScore(const Problem &problem,
          return kErrorScore;
       }
 
-      const int instrument = problem.musicians()[i];
       for(int j = 0; j < limit; j++)
       {
-         const Problem::Attendee &a = problem.attendees()[j];
-         if( IsAnyBlocking(placements, i, a.position) )
-            continue;
-
-         const double d2 = DistanceSquared(musician, a.position);
-         if( d2 < 100 )
+         if( DistanceSquared(musician, problem.attendees()[j].position) < 100 )
          {
             fprintf(stderr, "Musician %d collides with audience\n", i);
             return kErrorScore;
          }
-
-         score += std::ceil(1e6 * a.tastes[instrument] / d2);
       }
    }
 
+   // Lightning round problems have no pillars, no closeness extension,
+   // and no volumes.
+   const double score = ScoreCore<double, false, false, false>::LimitedScore(
+      problem.score_tables(),
+      placements.data(),
+      problem.musicians().data(),
+      nullptr,
+      static_cast<int>(problem.musicians().size()),
+      limit);
+
    #ifdef BENCHMARK
       const std::chrono::duration<double> elapsed =
          std::chrono::steady_clock::now() - start_time;